@@ -0,0 +1,68 @@
+#include "bench.h"
+#include "set.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+
+template <typename T>
+T make_value(std::size_t i) {
+  if constexpr (std::is_same_v<T, std::string>) {
+    return "replica-" + std::to_string(i) + std::string(16, '.');
+  } else {
+    return static_cast<T>(i);
+  }
+}
+
+// Two replicas of about `n` random elements, the second one a little larger. Assigns them to each other `rounds`
+// times in turn, with `assign_to(to, from)`. Reports ns per assigned element.
+template <typename Container, typename Assign>
+void run(const char* name, std::size_t n, int rounds, Assign&& assign_to) {
+  using T = typename Container::value_type;
+  std::mt19937_64 rng(5);
+  Container a;
+  Container b;
+  while (a.size() < n) {
+    a.insert(make_value<T>(rng()));
+  }
+  while (b.size() < n + n / 100) {
+    b.insert(make_value<T>(rng()));
+  }
+  bench::report(name, n, bench::ns_per_op(static_cast<std::size_t>(rounds) * n, [&] {
+                  for (int i = 0; i < rounds; ++i) {
+                    if (i % 2 == 0) {
+                      assign_to(a, b);
+                    } else {
+                      assign_to(b, a);
+                    }
+                  }
+                }));
+  bench::do_not_optimize(a.size());
+}
+
+template <typename T>
+void run_all(const char* type, std::size_t n, int rounds) {
+  std::printf("%s\n", type);
+  auto copy_assign = [](auto& to, const auto& from) { to = from; };
+  run<set<T, checked>>("set<checked>::operator=", n, rounds, copy_assign);
+  run<set<T, checked>>("set<checked>::assign", n, rounds, [](auto& to, const auto& from) { to.assign(from); });
+  run<set<T, unchecked>>("set<unchecked>::operator=", n, rounds, copy_assign);
+  run<set<T, unchecked>>("set<unchecked>::assign", n, rounds, [](auto& to, const auto& from) { to.assign(from); });
+  run<std::set<T>>("std::set::operator=", n, rounds, copy_assign);
+}
+
+} // namespace
+
+// Usage: assign [n], n defaults to 10^6.
+int main(int argc, char** argv) {
+  std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1'000'000;
+  run_all<std::uint64_t>("std::uint64_t", n, 10);
+  run_all<std::string>("std::string", n / 10, 10);
+}
@@ -0,0 +1,96 @@
+#include "bench.h"
+#include "set.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <set>
+#include <span>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t lookups = 1'000'000;
+
+// Random keys, half of them present in a set holding the even numbers below 2n.
+std::vector<int> probe_keys(std::size_t n) {
+  std::vector<int> keys(lookups);
+  std::mt19937 rng(17);
+  std::uniform_int_distribution<int> dist(0, static_cast<int>(2 * n - 1));
+  for (int& k : keys) {
+    k = dist(rng);
+  }
+  return keys;
+}
+
+// Resolves all the probe keys in calls of `batch` keys each. Reports ns per key.
+template <typename Container>
+void run(const char* name, std::size_t n) {
+  std::vector<int> values(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    values[i] = static_cast<int>(2 * i);
+  }
+  Container c(values.begin(), values.end());
+  values = {};
+  std::vector<int> keys = probe_keys(n);
+  std::vector<typename Container::const_iterator> found(64);
+  bool present[64];
+
+  std::printf("%s\n", name);
+  bench::report("find", 1, bench::ns_per_op(keys.size(), [&] {
+                  for (int k : keys) {
+                    bench::do_not_optimize(c.find(k));
+                  }
+                }));
+  for (std::size_t batch = 1; batch <= 64; batch *= 2) {
+    bench::report("find_many", batch, bench::ns_per_op(keys.size(), [&] {
+                    for (std::size_t i = 0; i < keys.size(); i += batch) {
+                      c.find_many(std::span<const int>(keys).subspan(i, batch), found);
+                      bench::do_not_optimize(found[0]);
+                    }
+                  }));
+  }
+  for (std::size_t batch : {1, 16, 64}) {
+    bench::report("lower_bound_many", batch, bench::ns_per_op(keys.size(), [&] {
+                    for (std::size_t i = 0; i < keys.size(); i += batch) {
+                      c.lower_bound_many(std::span<const int>(keys).subspan(i, batch), found);
+                      bench::do_not_optimize(found[0]);
+                    }
+                  }));
+    bench::report("contains_many", batch, bench::ns_per_op(keys.size(), [&] {
+                    for (std::size_t i = 0; i < keys.size(); i += batch) {
+                      c.contains_many(std::span<const int>(keys).subspan(i, batch), present);
+                      bench::do_not_optimize(present[0]);
+                    }
+                  }));
+  }
+}
+
+template <typename Container>
+void run_std(const char* name, std::size_t n) {
+  std::vector<int> values(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    values[i] = static_cast<int>(2 * i);
+  }
+  Container c(values.begin(), values.end());
+  values = {};
+  std::vector<int> keys = probe_keys(n);
+  std::printf("%s\n", name);
+  bench::report("find", 1, bench::ns_per_op(keys.size(), [&] {
+                  for (int k : keys) {
+                    bench::do_not_optimize(c.find(k));
+                  }
+                }));
+}
+
+} // namespace
+
+// Usage: batched-lookup [n], n defaults to 10^7. The batch size is the number of keys passed to one call.
+int main(int argc, char** argv) {
+  std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000'000;
+  run<set<int, unchecked>>("set<int, unchecked>", n);
+  run<set<int, checked>>("set<int, checked>", n);
+  run_std<std::set<int>>("std::set<int>", n);
+}
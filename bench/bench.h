@@ -0,0 +1,27 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+
+namespace bench {
+
+template <typename T>
+void do_not_optimize(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Runs `f` once and returns the elapsed time divided by `ops`.
+template <typename F>
+double ns_per_op(std::size_t ops, F&& f) {
+  auto start = std::chrono::steady_clock::now();
+  f();
+  auto finish = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(finish - start).count() / static_cast<double>(ops);
+}
+
+inline void report(const char* name, std::size_t param, double ns) {
+  std::printf("%-40s %10zu %12.2f ns/op\n", name, param, ns);
+}
+
+} // namespace bench
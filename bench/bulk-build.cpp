@@ -0,0 +1,54 @@
+#include "bench.h"
+#include "set.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace {
+
+void run(std::size_t n) {
+  std::vector<int> sorted(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    sorted[i] = static_cast<int>(i * 2);
+  }
+  std::vector<int> shuffled = sorted;
+  std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(3));
+
+  bench::report("std::set(sorted range)", n, bench::ns_per_op(n, [&] {
+                  std::set<int> s(sorted.begin(), sorted.end());
+                  bench::do_not_optimize(s);
+                }));
+  bench::report("set(sorted range)", n, bench::ns_per_op(n, [&] {
+                  set<int, unchecked> s(sorted.begin(), sorted.end());
+                  bench::do_not_optimize(s);
+                }));
+  bench::report("set + insert loop (sorted)", n, bench::ns_per_op(n, [&] {
+                  set<int, unchecked> s;
+                  for (int v : sorted) {
+                    s.insert(v);
+                  }
+                  bench::do_not_optimize(s);
+                }));
+  bench::report("set(shuffled range)", n, bench::ns_per_op(n, [&] {
+                  set<int, unchecked> s(shuffled.begin(), shuffled.end());
+                  bench::do_not_optimize(s);
+                }));
+  bench::report("set + insert loop (shuffled)", n, bench::ns_per_op(n, [&] {
+                  set<int, unchecked> s;
+                  for (int v : shuffled) {
+                    s.insert(v);
+                  }
+                  bench::do_not_optimize(s);
+                }));
+}
+
+} // namespace
+
+int main() {
+  for (std::size_t n : {100'000, 1'000'000, 4'000'000}) {
+    run(n);
+  }
+}
@@ -0,0 +1,74 @@
+#include "bench.h"
+#include "set.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace {
+
+std::size_t allocated_bytes = 0;
+
+template <typename Set>
+void run(const char* name, const std::vector<int>& keys) {
+  std::size_t before = allocated_bytes;
+  Set s;
+  double insert_ns = bench::ns_per_op(keys.size(), [&] {
+    for (int k : keys) {
+      s.insert(k);
+    }
+  });
+  std::size_t bytes = allocated_bytes - before;
+
+  double find_ns = bench::ns_per_op(keys.size(), [&] {
+    for (int k : keys) {
+      bench::do_not_optimize(s.find(k));
+    }
+  });
+
+  double iterate_ns = bench::ns_per_op(keys.size(), [&] {
+    long long sum = 0;
+    for (auto it = s.begin(); it != s.end(); ++it) {
+      sum += *it;
+    }
+    bench::do_not_optimize(sum);
+  });
+
+  std::printf("%-24s insert %8.2f  find %8.2f  iterate %6.2f ns/op  %6.1f bytes/element  sizeof(iterator) %zu\n",
+              name, insert_ns, find_ns, iterate_ns, static_cast<double>(bytes) / static_cast<double>(keys.size()),
+              sizeof(typename Set::iterator));
+}
+
+} // namespace
+
+void* operator new(std::size_t count) {
+  allocated_bytes += count;
+  if (void* ptr = std::malloc(count)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+int main() {
+  constexpr std::size_t n = 1'000'000;
+  std::vector<int> keys(n);
+  std::mt19937 rng(42);
+  for (int& k : keys) {
+    k = static_cast<int>(rng());
+  }
+
+  run<std::set<int>>("std::set<int>", keys);
+  run<set<int, unchecked>>("set<int, unchecked>", keys);
+  run<set<int, checked>>("set<int, checked>", keys);
+}
@@ -0,0 +1,88 @@
+#include "bench.h"
+#include "set.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <vector>
+
+namespace {
+
+std::size_t allocations = 0;
+
+struct result {
+  double ns_per_op;
+  double p99_insert_ns;
+  std::size_t allocations;
+};
+
+// Bursts of `burst` inserts followed by `burst` erases on a set of `base` elements.
+template <bool Reserve>
+result churn(std::size_t base, std::size_t burst, std::size_t rounds) {
+  std::mt19937 rng(7);
+  set<int, unchecked> s;
+  if constexpr (Reserve) {
+    s.reserve(base + burst);
+  }
+  for (std::size_t i = 0; i < base; ++i) {
+    s.insert(static_cast<int>(rng() >> 1));
+  }
+
+  std::vector<int> keys(burst);
+  std::vector<double> latencies;
+  latencies.reserve(rounds * burst);
+  std::size_t allocations_before = allocations;
+  auto start = std::chrono::steady_clock::now();
+  for (std::size_t r = 0; r < rounds; ++r) {
+    for (int& k : keys) {
+      k = static_cast<int>(rng() >> 1);
+      auto op_start = std::chrono::steady_clock::now();
+      s.insert(k);
+      auto op_finish = std::chrono::steady_clock::now();
+      latencies.push_back(std::chrono::duration<double, std::nano>(op_finish - op_start).count());
+    }
+    for (int k : keys) {
+      s.erase(k);
+    }
+  }
+  auto finish = std::chrono::steady_clock::now();
+  std::size_t ops = rounds * burst * 2;
+  std::nth_element(latencies.begin(), latencies.begin() + latencies.size() * 99 / 100, latencies.end());
+  return {std::chrono::duration<double, std::nano>(finish - start).count() / static_cast<double>(ops),
+          latencies[latencies.size() * 99 / 100], allocations - allocations_before};
+}
+
+void print(const char* name, std::size_t burst, const result& r) {
+  std::printf("%-20s burst %6zu  %8.2f ns/op  p99 insert %8.2f ns  %8zu allocations\n", name, burst, r.ns_per_op,
+              r.p99_insert_ns, r.allocations);
+}
+
+} // namespace
+
+void* operator new(std::size_t count) {
+  ++allocations;
+  if (void* ptr = std::malloc(count)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+int main() {
+  constexpr std::size_t base = 100'000;
+  for (std::size_t burst : {1'000, 10'000, 100'000}) {
+    std::size_t rounds = 1'000'000 / burst;
+    print("without reserve", burst, churn<false>(base, burst, rounds));
+    print("with reserve", burst, churn<true>(base, burst, rounds));
+  }
+}
@@ -0,0 +1,70 @@
+#include "bench.h"
+#include "set.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace {
+
+template <typename Container>
+Container make(int first, int count) {
+  Container c;
+  for (int i = 0; i < count; ++i) {
+    c.insert(first + i);
+  }
+  return c;
+}
+
+// Keeps `sets` sets of `size` elements in a vector: growing it, shuffling it and taking sets out of it move whole
+// sets around. Also assigns search results to a live iterator. Reports ns per moved set or per search.
+template <typename Container>
+void run(const char* name, std::size_t sets, int size) {
+  std::vector<Container> prepared;
+  for (std::size_t i = 0; i < sets; ++i) {
+    prepared.push_back(make<Container>(static_cast<int>(i), size));
+  }
+
+  std::printf("%s\n", name);
+  std::vector<Container> grown;
+  bench::report("push_back with regrowth", sets, bench::ns_per_op(sets, [&] {
+                  for (Container& c : prepared) {
+                    grown.push_back(std::move(c));
+                  }
+                }));
+  std::mt19937 rng(3);
+  bench::report("shuffle", sets, bench::ns_per_op(sets, [&] { std::shuffle(grown.begin(), grown.end(), rng); }));
+  bench::report("take out and put back", sets, bench::ns_per_op(sets, [&] {
+                  for (Container& c : grown) {
+                    Container taken = std::move(c);
+                    bench::do_not_optimize(taken.size());
+                    c = std::move(taken);
+                  }
+                }));
+
+  Container& probe = grown.front();
+  typename Container::const_iterator it = probe.begin();
+  std::size_t searches = sets * 16;
+  bench::report("iterator = find(key)", searches, bench::ns_per_op(searches, [&] {
+                  for (std::size_t i = 0; i < searches; ++i) {
+                    it = probe.find(*probe.begin() + static_cast<int>(i % static_cast<std::size_t>(size)));
+                    bench::do_not_optimize(it);
+                  }
+                }));
+}
+
+} // namespace
+
+// Usage: container-of-sets [sets] [size], defaulting to 10^4 sets of 100 elements.
+int main(int argc, char** argv) {
+  std::size_t sets = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000;
+  int size = argc > 2 ? std::atoi(argv[2]) : 100;
+  run<set<int, checked>>("set<int, checked>", sets, size);
+  run<set<int, unchecked>>("set<int, unchecked>", sets, size);
+  run<std::set<int>>("std::set<int>", sets, size);
+}
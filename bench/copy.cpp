@@ -0,0 +1,32 @@
+#include "bench.h"
+#include "set.h"
+
+#include <cstddef>
+#include <random>
+#include <set>
+
+namespace {
+
+template <typename Set>
+void run(const char* name, std::size_t n) {
+  std::mt19937 rng(1);
+  Set s;
+  for (std::size_t i = 0; i < n; ++i) {
+    s.insert(static_cast<int>(rng()));
+  }
+  double ns = bench::ns_per_op(s.size(), [&] {
+    Set copy = s;
+    bench::do_not_optimize(copy);
+  });
+  bench::report(name, n, ns);
+}
+
+} // namespace
+
+int main() {
+  for (std::size_t n : {10'000, 100'000, 1'000'000, 4'000'000}) {
+    run<std::set<int>>("copy std::set<int>", n);
+    run<set<int, unchecked>>("copy set<int, unchecked>", n);
+    run<set<int, checked>>("copy set<int, checked>", n);
+  }
+}
@@ -0,0 +1,75 @@
+#include "bench.h"
+#include "set.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Instrumented value in the spirit of `test/element.h`: counts deep copies and moves.
+struct counted {
+  static inline std::size_t copies = 0;
+  static inline std::size_t moves = 0;
+
+  explicit counted(std::size_t id) : payload(64, 'x') {
+    payload += std::to_string(id);
+  }
+
+  counted(const counted& other) : payload(other.payload) {
+    ++copies;
+  }
+
+  counted(counted&& other) noexcept : payload(std::move(other.payload)) {
+    ++moves;
+  }
+
+  counted& operator=(const counted&) = default;
+  counted& operator=(counted&&) = default;
+
+  friend bool operator<(const counted& a, const counted& b) {
+    return a.payload < b.payload;
+  }
+
+  std::string payload;
+
+  static void reset() {
+    copies = 0;
+    moves = 0;
+  }
+};
+
+constexpr std::size_t n = 200'000;
+
+template <typename F>
+void run(const char* name, F&& insert_all) {
+  std::vector<counted> values;
+  values.reserve(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    values.emplace_back(i * 7919 % n);
+  }
+  set<counted, unchecked> s;
+  counted::reset();
+  double ns = bench::ns_per_op(n, [&] { insert_all(s, values); });
+  std::printf("%-24s %10.2f ns/op  %8zu copies  %8zu moves\n", name, ns, counted::copies, counted::moves);
+}
+
+} // namespace
+
+int main() {
+  run("insert(const T&)", [](auto& s, auto& values) {
+    for (const counted& v : values) {
+      s.insert(v);
+    }
+  });
+  run("insert(T&&)", [](auto& s, auto& values) {
+    for (counted& v : values) {
+      s.insert(std::move(v));
+    }
+  });
+  run("emplace(args...)", [](auto& s, auto& values) {
+    for (std::size_t i = 0; i < values.size(); ++i) {
+      s.emplace(i * 7919 % n);
+    }
+  });
+}
@@ -0,0 +1,63 @@
+#include "bench.h"
+#include "set.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+#include <vector>
+
+namespace {
+
+// Calls that only need the ends of the set: scanning short sets with `end()` in the loop test, `begin()` and
+// `rbegin()` on a large one, and draining it from the front. Reports ns per call or per visited element.
+template <typename Container>
+void run(const char* name, std::size_t n) {
+  std::vector<int> keys(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    keys[i] = static_cast<int>(i * 7919 % n);
+  }
+  Container large(keys.begin(), keys.end());
+  std::vector<Container> small(n / 8);
+  for (std::size_t i = 0; i < small.size(); ++i) {
+    for (int k = 0; k < 8; ++k) {
+      small[i].insert(static_cast<int>(i) + k);
+    }
+  }
+
+  std::printf("%s\n", name);
+  bench::report("scan sets of 8", n, bench::ns_per_op(n, [&] {
+                  long long sum = 0;
+                  for (const Container& c : small) {
+                    for (auto it = c.begin(); it != c.end(); ++it) {
+                      sum += *it;
+                    }
+                  }
+                  bench::do_not_optimize(sum);
+                }));
+  bench::report("begin()", n, bench::ns_per_op(n, [&] {
+                  for (std::size_t i = 0; i < n; ++i) {
+                    bench::do_not_optimize(*large.begin());
+                  }
+                }));
+  bench::report("rbegin()", n, bench::ns_per_op(n, [&] {
+                  for (std::size_t i = 0; i < n; ++i) {
+                    bench::do_not_optimize(*large.rbegin());
+                  }
+                }));
+  bench::report("erase(begin()) until empty", n, bench::ns_per_op(n, [&] {
+                  while (!large.empty()) {
+                    large.erase(large.begin());
+                  }
+                }));
+}
+
+} // namespace
+
+// Usage: extremes [n], n defaults to 10^6.
+int main(int argc, char** argv) {
+  std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1'000'000;
+  run<set<int, checked>>("set<int, checked>", n);
+  run<set<int, unchecked>>("set<int, unchecked>", n);
+  run<std::set<int>>("std::set<int>", n);
+}
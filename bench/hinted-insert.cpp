@@ -0,0 +1,72 @@
+#include "bench.h"
+#include "set.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Increasing keys where every `swap_every`-th key changes places with the next one (0 keeps them monotone).
+std::vector<int> stream(std::size_t n, std::size_t swap_every) {
+  std::vector<int> keys(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    keys[i] = static_cast<int>(i);
+  }
+  if (swap_every != 0) {
+    std::mt19937 rng(7);
+    for (std::size_t i = 0; i + 1 < n; ++i) {
+      if (rng() % swap_every == 0) {
+        std::swap(keys[i], keys[i + 1]);
+      }
+    }
+  }
+  return keys;
+}
+
+double plain(const std::vector<int>& keys) {
+  set<int, unchecked> s;
+  return bench::ns_per_op(keys.size(), [&] {
+    for (int k : keys) {
+      s.insert(k);
+    }
+    bench::do_not_optimize(s.size());
+  });
+}
+
+double hint_end(const std::vector<int>& keys) {
+  set<int, unchecked> s;
+  return bench::ns_per_op(keys.size(), [&] {
+    for (int k : keys) {
+      s.insert(s.end(), k);
+    }
+    bench::do_not_optimize(s.size());
+  });
+}
+
+double hint_previous(const std::vector<int>& keys) {
+  set<int, unchecked> s;
+  return bench::ns_per_op(keys.size(), [&] {
+    auto hint = s.end();
+    for (int k : keys) {
+      hint = s.insert(hint, k);
+    }
+    bench::do_not_optimize(s.size());
+  });
+}
+
+} // namespace
+
+int main() {
+  constexpr std::size_t n = 1'000'000;
+  for (std::size_t swap_every : {0, 10}) {
+    std::vector<int> keys = stream(n, swap_every);
+    const char* kind = swap_every == 0 ? "monotone" : "near-monotone";
+    std::printf("%s\n", kind);
+    bench::report("insert(value)", n, plain(keys));
+    bench::report("insert(end(), value)", n, hint_end(keys));
+    bench::report("insert(previous, value)", n, hint_previous(keys));
+  }
+}
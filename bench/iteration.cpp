@@ -0,0 +1,73 @@
+#include "bench.h"
+#include "set.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace {
+
+std::vector<int> random_keys(std::size_t n) {
+  std::vector<int> keys(n);
+  std::mt19937 rng(11);
+  for (int& k : keys) {
+    k = static_cast<int>(rng() >> 1);
+  }
+  return keys;
+}
+
+// Full forward, backward and reverse-iterator scans and one bound search per key. Reports ns per visited element or
+// per search. Every container is filled in the same random order, so that its nodes are equally scattered in memory.
+template <typename Container>
+void run(const char* name, const std::vector<int>& keys) {
+  Container c;
+  for (int k : keys) {
+    c.insert(k);
+  }
+  std::printf("%s\n", name);
+  bench::report("forward scan", c.size(), bench::ns_per_op(c.size(), [&] {
+                  long long sum = 0;
+                  for (auto it = c.begin(); it != c.end(); ++it) {
+                    sum += *it;
+                  }
+                  bench::do_not_optimize(sum);
+                }));
+  bench::report("backward scan", c.size(), bench::ns_per_op(c.size(), [&] {
+                  long long sum = 0;
+                  for (auto it = c.end(); it != c.begin();) {
+                    sum += *--it;
+                  }
+                  bench::do_not_optimize(sum);
+                }));
+  bench::report("reverse scan", c.size(), bench::ns_per_op(c.size(), [&] {
+                  long long sum = 0;
+                  for (auto it = c.rbegin(); it != c.rend(); ++it) {
+                    sum += *it;
+                  }
+                  bench::do_not_optimize(sum);
+                }));
+  bench::report("lower_bound", keys.size(), bench::ns_per_op(keys.size(), [&] {
+                  for (int k : keys) {
+                    bench::do_not_optimize(c.lower_bound(k + 1));
+                  }
+                }));
+  bench::report("upper_bound", keys.size(), bench::ns_per_op(keys.size(), [&] {
+                  for (int k : keys) {
+                    bench::do_not_optimize(c.upper_bound(k));
+                  }
+                }));
+}
+
+} // namespace
+
+// Usage: iteration [n], n defaults to 10^6.
+int main(int argc, char** argv) {
+  std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1'000'000;
+  std::vector<int> keys = random_keys(n);
+  run<set<int, checked>>("set<int, checked>", keys);
+  run<set<int, unchecked>>("set<int, unchecked>", keys);
+  run<std::set<int>>("std::set<int>", keys);
+}
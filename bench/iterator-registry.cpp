@@ -0,0 +1,74 @@
+#include "bench.h"
+#include "set.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace {
+
+using container = set<int>;
+
+// Copies and destroys an iterator while `live` other iterators point to the same node.
+void bench_copy(std::size_t live) {
+  container c;
+  for (int i = 0; i < 16; ++i) {
+    c.insert(i);
+  }
+  container::const_iterator hot = c.find(8);
+  std::vector<container::const_iterator> cursors(live, hot);
+
+  constexpr std::size_t ops = 1'000'000;
+  double ns = bench::ns_per_op(ops, [&] {
+    for (std::size_t i = 0; i < ops; ++i) {
+      container::const_iterator copy = cursors[i % live];
+      bench::do_not_optimize(copy);
+    }
+  });
+  bench::report("copy+destroy with N live cursors", live, ns);
+}
+
+// Destroys `live` iterators in construction order, the worst case for a linear registry.
+void bench_fifo_destroy(std::size_t live) {
+  container c;
+  c.insert(42);
+  container::const_iterator hot = c.begin();
+
+  constexpr std::size_t rounds = 64;
+  double ns = bench::ns_per_op(rounds * live, [&] {
+    for (std::size_t r = 0; r < rounds; ++r) {
+      std::vector<container::const_iterator> cursors(live, hot);
+      cursors.erase(cursors.begin(), cursors.end());
+      bench::do_not_optimize(cursors);
+    }
+  });
+  bench::report("fifo register+unregister", live, ns);
+}
+
+// Erases a node that has `live` iterators on it.
+void bench_erase_hot_node(std::size_t live) {
+  constexpr std::size_t rounds = 256;
+  double total = 0;
+  for (std::size_t r = 0; r < rounds; ++r) {
+    container c;
+    for (int i = 0; i < 16; ++i) {
+      c.insert(i);
+    }
+    std::vector<container::const_iterator> cursors(live, c.find(8));
+    total += bench::ns_per_op(1, [&] { c.erase(c.find(8)); });
+  }
+  bench::report("erase node with N live cursors", live, total / rounds);
+}
+
+} // namespace
+
+int main() {
+  for (std::size_t live : {1, 16, 256, 4096}) {
+    bench_copy(live);
+  }
+  for (std::size_t live : {1, 16, 256, 4096}) {
+    bench_fifo_destroy(live);
+  }
+  for (std::size_t live : {1, 16, 256, 4096}) {
+    bench_erase_hot_node(live);
+  }
+}
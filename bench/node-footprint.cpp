@@ -0,0 +1,77 @@
+#include "bench.h"
+#include "set.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <set>
+#include <string>
+
+namespace {
+
+std::size_t allocated_bytes = 0;
+
+// Forwards to `std::allocator` and counts the bytes it hands out, so that the size of a node is seen from outside.
+template <typename T>
+struct counting_allocator {
+  using value_type = T;
+
+  counting_allocator() = default;
+
+  template <typename U>
+  counting_allocator(const counting_allocator<U>&) noexcept {}
+
+  T* allocate(std::size_t count) {
+    allocated_bytes += count * sizeof(T);
+    return std::allocator<T>().allocate(count);
+  }
+
+  void deallocate(T* ptr, std::size_t count) noexcept {
+    std::allocator<T>().deallocate(ptr, count);
+  }
+
+  friend bool operator==(const counting_allocator&, const counting_allocator&) {
+    return true;
+  }
+};
+
+// Prints the bytes the container allocates per element and how many of them are overhead over `sizeof(T)`.
+template <typename Container>
+void report(const char* name, std::size_t n) {
+  using T = typename Container::value_type;
+  allocated_bytes = 0;
+  {
+    Container c;
+    for (std::size_t i = 0; i < n; ++i) {
+      if constexpr (std::is_same_v<T, std::string>) {
+        c.insert(std::to_string(i));
+      } else {
+        c.insert(static_cast<T>(i));
+      }
+    }
+    bench::do_not_optimize(c.size());
+  }
+  double per_element = static_cast<double>(allocated_bytes) / static_cast<double>(n);
+  std::printf("%-40s %10zu %8.1f bytes/element %8.1f overhead\n", name, n, per_element,
+              per_element - static_cast<double>(sizeof(T)));
+}
+
+template <typename T, typename Checking>
+using counted_set = set<T, Checking, std::less<T>, counting_allocator<T>>;
+
+template <typename T>
+using counted_std_set = std::set<T, std::less<T>, counting_allocator<T>>;
+
+} // namespace
+
+int main() {
+  constexpr std::size_t n = 100'000;
+  std::printf("sizeof(set<int>) %zu, sizeof(set<int>::iterator) %zu, sizeof(set<int, unchecked>::iterator) %zu\n",
+              sizeof(set<int>), sizeof(set<int>::iterator), sizeof(set<int, unchecked>::iterator));
+  report<counted_set<int, checked>>("set<int, checked>", n);
+  report<counted_set<int, unchecked>>("set<int, unchecked>", n);
+  report<counted_std_set<int>>("std::set<int>", n);
+  report<counted_set<std::string, checked>>("set<std::string, checked>", n);
+  report<counted_set<std::string, unchecked>>("set<std::string, unchecked>", n);
+  report<counted_std_set<std::string>>("std::set<std::string>", n);
+}
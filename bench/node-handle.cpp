@@ -0,0 +1,52 @@
+#include "bench.h"
+#include "set.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+using container = set<std::string, unchecked>;
+
+// Keys long enough to live on the heap, so that copying one costs an allocation.
+std::vector<std::string> keys(std::size_t n) {
+  std::vector<std::string> result;
+  for (std::size_t i = 0; i < n; ++i) {
+    result.push_back("request-" + std::to_string(i * 7919 % n) + std::string(24, '.'));
+  }
+  return result;
+}
+
+// Moves every element from `pending` to `active` and back. Reports ns per moved element.
+template <typename F>
+void run(const char* name, const std::vector<std::string>& all, F&& move_all) {
+  container pending(all.begin(), all.end());
+  container active;
+  bench::report(name, all.size(), bench::ns_per_op(2 * all.size(), [&] {
+                  move_all(pending, active);
+                  move_all(active, pending);
+                }));
+  bench::do_not_optimize(pending.size());
+}
+
+} // namespace
+
+int main() {
+  for (std::size_t n : {1'000, 100'000}) {
+    std::vector<std::string> all = keys(n);
+    run("insert copy and erase", all, [](container& from, container& to) {
+      while (!from.empty()) {
+        to.insert(*from.begin());
+        from.erase(from.begin());
+      }
+    });
+    run("extract and insert(node_type&&)", all, [](container& from, container& to) {
+      while (!from.empty()) {
+        to.insert(from.extract(from.begin()));
+      }
+    });
+    run("merge", all, [](container& from, container& to) { to.merge(from); });
+  }
+}
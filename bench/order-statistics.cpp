@@ -0,0 +1,82 @@
+#include "bench.h"
+#include "set.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <new>
+#include <random>
+#include <vector>
+
+namespace {
+
+std::size_t allocated_bytes = 0;
+
+using container = set<int, unchecked>;
+
+} // namespace
+
+void* operator new(std::size_t count) {
+  allocated_bytes += count;
+  if (void* ptr = std::malloc(count)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+// Usage: order-statistics [n], n defaults to 10^6.
+int main(int argc, char** argv) {
+  std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1'000'000;
+  std::vector<int> keys(n);
+  std::mt19937 rng(3);
+  for (int& k : keys) {
+    k = static_cast<int>(rng() >> 1);
+  }
+
+  container c;
+  std::size_t bytes_before = allocated_bytes;
+  bench::report("insert", n, bench::ns_per_op(n, [&] {
+                  for (int k : keys) {
+                    c.insert(k);
+                  }
+                }));
+  std::printf("%-40s %10zu %12.2f bytes/element\n", "memory", c.size(),
+              static_cast<double>(allocated_bytes - bytes_before) / static_cast<double>(c.size()));
+
+  bench::report("rank", n, bench::ns_per_op(n, [&] {
+                  for (int k : keys) {
+                    bench::do_not_optimize(c.rank(k));
+                  }
+                }));
+  bench::report("nth", n, bench::ns_per_op(n, [&] {
+                  for (std::size_t i = 0; i < n; ++i) {
+                    bench::do_not_optimize(c.nth(keys[i] % c.size()));
+                  }
+                }));
+
+  constexpr std::size_t samples = 16;
+  container::const_iterator middle = c.nth(c.size() / 2);
+  bench::report("std::ranges::distance to the middle", samples, bench::ns_per_op(samples, [&] {
+                  for (std::size_t i = 0; i < samples; ++i) {
+                    bench::do_not_optimize(std::ranges::distance(c.begin(), middle));
+                  }
+                }));
+  bench::report("walk to the middle", samples, bench::ns_per_op(samples, [&] {
+                  for (std::size_t i = 0; i < samples; ++i) {
+                    std::ptrdiff_t steps = 0;
+                    for (auto it = c.begin(); it != middle; ++it) {
+                      ++steps;
+                    }
+                    bench::do_not_optimize(steps);
+                  }
+                }));
+}
@@ -0,0 +1,39 @@
+#include "bench.h"
+#include "set.h"
+
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Every thread fills its own set, so any slowdown with more threads comes from state the sets share.
+double parallel_insert(std::size_t threads, std::size_t per_thread) {
+  std::vector<set<int, unchecked>> sets(threads);
+  for (auto& s : sets) {
+    s.reserve(per_thread);
+  }
+  return bench::ns_per_op(per_thread, [&] {
+    std::vector<std::thread> workers;
+    for (auto& s : sets) {
+      workers.emplace_back([&s, per_thread] {
+        for (std::size_t i = 0; i < per_thread; ++i) {
+          s.insert(static_cast<int>(i * 2654435761u));
+        }
+      });
+    }
+    for (auto& w : workers) {
+      w.join();
+    }
+  });
+}
+
+} // namespace
+
+int main() {
+  constexpr std::size_t per_thread = 1'000'000;
+  std::size_t hardware = std::thread::hardware_concurrency();
+  for (std::size_t threads = 1; threads <= (hardware ? hardware : 1) * 2; threads *= 2) {
+    bench::report("parallel insert, threads", threads, parallel_insert(threads, per_thread));
+  }
+}
@@ -0,0 +1,48 @@
+#include "bench.h"
+#include "set.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+using container = set<int, unchecked>;
+
+container make(std::size_t n) {
+  std::vector<int> keys(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    keys[i] = static_cast<int>(i);
+  }
+  return container(keys.begin(), keys.end());
+}
+
+// Expires everything below a watermark that advances by `window` keys at a time. Reports ns per erased element.
+template <typename F>
+void run(const char* name, std::size_t n, std::size_t window, F&& trim) {
+  container s = make(n);
+  bench::report(name, window, bench::ns_per_op(n, [&] {
+                  for (std::size_t mark = window; mark <= n; mark += window) {
+                    trim(s, static_cast<int>(mark));
+                  }
+                }));
+  bench::do_not_optimize(s.size());
+}
+
+} // namespace
+
+// Usage: range-erase [n], n defaults to 10^6.
+int main(int argc, char** argv) {
+  std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1'000'000;
+  for (std::size_t window : {std::size_t(10), std::size_t(1'000), n / 10}) {
+    run("erase(begin()) one by one", n, window, [](container& s, int mark) {
+      while (!s.empty() && *s.begin() < mark) {
+        s.erase(s.begin());
+      }
+    });
+    run("erase(begin(), lower_bound(mark))", n, window,
+        [](container& s, int mark) { s.erase(s.begin(), s.lower_bound(mark)); });
+    run("erase_range(min, mark)", n, window, [](container& s, int mark) { s.erase_range(0, mark); });
+  }
+}
@@ -0,0 +1,71 @@
+#include "bench.h"
+#include "set.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using container = set<int, unchecked>;
+
+container make(std::size_t n) {
+  std::vector<int> keys(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    keys[i] = static_cast<int>(i);
+  }
+  return container(keys.begin(), keys.end());
+}
+
+// Times `op` on the calling thread `rounds` times, each on a fresh set of `n` elements, and prints the median and
+// the 99th percentile in microseconds. `op` may delete the set and reset the pointer; otherwise it is deleted
+// synchronously after the measurement.
+template <typename F>
+void run(const char* name, std::size_t n, int rounds, background_reclaimer* reclaimer, F&& op) {
+  std::vector<double> samples;
+  for (int i = 0; i < rounds; ++i) {
+    container* s = new container(make(n));
+    s->reclaim_with(reclaimer);
+    auto start = std::chrono::steady_clock::now();
+    op(s);
+    auto finish = std::chrono::steady_clock::now();
+    samples.push_back(std::chrono::duration<double, std::micro>(finish - start).count());
+    if (s) {
+      s->reclaim_with(nullptr);
+      delete s;
+    }
+    if (reclaimer) {
+      // keeps the worker from competing with the next round
+      reclaimer->drain();
+    }
+  }
+  std::sort(samples.begin(), samples.end());
+  double p50 = samples[samples.size() / 2];
+  double p99 = samples[std::min(samples.size() - 1, samples.size() * 99 / 100)];
+  std::printf("%-40s %10zu %12.1f us p50 %12.1f us p99\n", name, n, p50, p99);
+}
+
+} // namespace
+
+// Usage: reclaim-latency [n], n defaults to 10^6.
+int main(int argc, char** argv) {
+  std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1'000'000;
+  background_reclaimer reclaimer;
+  for (background_reclaimer* r : {static_cast<background_reclaimer*>(nullptr), &reclaimer}) {
+    const char* mode = r ? "background" : "synchronous";
+    std::printf("%s\n", mode);
+    run("clear()", n, 50, r, [](container*& s) {
+      s->clear();
+      bench::do_not_optimize(s->size());
+    });
+    run("~set()", n, 50, r, [](container*& s) { delete std::exchange(s, nullptr); });
+    run("erase_range(half)", n, 50, r, [n](container*& s) {
+      s->erase_range(0, static_cast<int>(n / 2));
+      bench::do_not_optimize(s->size());
+    });
+  }
+}
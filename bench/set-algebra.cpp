@@ -0,0 +1,56 @@
+#include "bench.h"
+#include "set.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+using container = set<int, unchecked>;
+
+// Every `step`-th key starting at `offset`, so that two streams overlap in a known fraction of their keys.
+container make(std::size_t n, int step, int offset) {
+  std::vector<int> keys(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    keys[i] = static_cast<int>(i) * step + offset;
+  }
+  return container(keys.begin(), keys.end());
+}
+
+template <typename F>
+void run(const char* name, std::size_t large, std::size_t small, F&& op) {
+  // the small set is spread over the whole key range of the large one
+  int step = static_cast<int>(large / small);
+  container big = make(large, 2, 0);
+  container little = make(small, step * 2, 1 - (static_cast<int>(small) % 2));
+  bench::report(name, small, bench::ns_per_op(small, [&] { op(big, little); }));
+  bench::do_not_optimize(big.size());
+}
+
+} // namespace
+
+// Usage: set-algebra [n], n defaults to 10^7. Reports ns per element of the small set.
+int main(int argc, char** argv) {
+  std::size_t large = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000'000;
+  for (std::size_t small : {std::size_t(1'000), large / 100, large}) {
+    std::printf("large set of %zu elements\n", large);
+    run("merge_union", large, small, [](container& a, container& b) { a.merge_union(std::move(b)); });
+    run("insert one by one", large, small, [](container& a, container& b) {
+      for (int x : b) {
+        a.insert(x);
+      }
+    });
+    run("intersect, small with large", large, small, [](container& a, container& b) { b.intersect(a); });
+    run("difference", large, small, [](container& a, container& b) { a.difference(std::move(b)); });
+    run("erase one by one", large, small, [](container& a, container& b) {
+      for (int x : b) {
+        a.erase(x);
+      }
+    });
+    run("symmetric_difference", large, small,
+        [](container& a, container& b) { a.symmetric_difference(std::move(b)); });
+  }
+}
@@ -0,0 +1,68 @@
+#include "bench.h"
+#include "set.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+using container = set<int, unchecked>;
+
+container make(int from, int to) {
+  std::vector<int> keys;
+  for (int i = from; i < to; ++i) {
+    keys.push_back(i);
+  }
+  return container(keys.begin(), keys.end());
+}
+
+// Moves the top `moved` keys of the left shard into the right one and back again, `rounds` times. Reports ns per
+// round.
+template <typename F>
+void run(const char* name, int n, int moved, int rounds, F&& rebalance) {
+  container left = make(0, n);
+  container right = make(n, 2 * n);
+  bench::report(name, static_cast<std::size_t>(moved), bench::ns_per_op(static_cast<std::size_t>(rounds), [&] {
+                  for (int i = 0; i < rounds; ++i) {
+                    rebalance(left, right, n - moved);
+                    rebalance(left, right, n);
+                  }
+                }));
+  bench::do_not_optimize(left.size() + right.size());
+}
+
+} // namespace
+
+// Usage: split-join [n], n defaults to 10^6 elements per shard.
+int main(int argc, char** argv) {
+  int n = argc > 1 ? std::atoi(argv[1]) : 1'000'000;
+  for (int moved : {1'000, n / 10}) {
+    // moves everything from `boundary` on into `right`, or the keys below `boundary` back into `left`
+    run("copy and erase", n, moved, 5, [](container& left, container& right, int boundary) {
+      if (left.lower_bound(boundary) != left.end()) {
+        for (auto it = left.lower_bound(boundary); it != left.end(); ++it) {
+          right.insert(*it);
+        }
+        left.erase_range(boundary, 2 * boundary);
+      } else {
+        for (auto it = right.begin(); it != right.end() && *it < boundary; ++it) {
+          left.insert(*it);
+        }
+        right.erase_range(0, boundary);
+      }
+    });
+    run("split_off and join", n, moved, 5, [](container& left, container& right, int boundary) {
+      if (left.lower_bound(boundary) != left.end()) {
+        container tail = left.split_off(boundary);
+        tail.join(std::move(right));
+        swap(tail, right);
+      } else {
+        container head = right.split_off(boundary);
+        left.join(std::move(right));
+        swap(head, right);
+      }
+    });
+  }
+}
@@ -0,0 +1,39 @@
+#include "bench.h"
+#include "set.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+// Usage: treap-ops [n], n defaults to 10^7.
+int main(int argc, char** argv) {
+  std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000'000;
+  std::vector<int> keys(n);
+  std::mt19937 rng(5);
+  for (int& k : keys) {
+    k = static_cast<int>(rng() >> 1);
+  }
+
+  auto* s = new set<int, unchecked>;
+  bench::report("insert", n, bench::ns_per_op(n, [&] {
+                  for (int k : keys) {
+                    s->insert(k);
+                  }
+                }));
+  bench::report("find", n, bench::ns_per_op(n, [&] {
+                  for (int k : keys) {
+                    bench::do_not_optimize(s->find(k));
+                  }
+                }));
+  set<int, unchecked> copy = *s;
+  bench::report("erase by value (half)", n / 2, bench::ns_per_op(n / 2, [&] {
+                  for (std::size_t i = 0; i < n / 2; ++i) {
+                    s->erase(keys[i]);
+                  }
+                }));
+  std::size_t remaining = s->size();
+  bench::report("destroy", remaining, bench::ns_per_op(remaining, [&] { delete s; }));
+  std::size_t copied = copy.size();
+  bench::report("clear", copied, bench::ns_per_op(copied, [&] { copy.clear(); }));
+}
@@ -1,49 +1,328 @@
 #pragma once
 
-#include <cassert>
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <initializer_list>
 #include <iterator>
-#include <random>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
-std::mt19937 mt;
 
-template <typename T>
+// Checking policies for `set`.
+//
+// `checked` registers every iterator in its node and aborts on any incorrect usage, regardless of `NDEBUG`.
+// `unchecked` keeps no registry and performs no validation: its iterator is a bare node pointer.
+struct checked {};
+
+struct unchecked {};
+
+// A worker thread that frees the trees detached by `clear()`, the destructor and range erases of the sets attached to
+// it with `set::reclaim_with`. It has to outlive those sets; its destructor finishes the queued work first.
+class background_reclaimer {
+public:
+  background_reclaimer() : _worker([this] { run(); }) {}
+
+  background_reclaimer(const background_reclaimer&) = delete;
+  background_reclaimer& operator=(const background_reclaimer&) = delete;
+
+  ~background_reclaimer() {
+    {
+      std::lock_guard lock(_mutex);
+      _stopping = true;
+    }
+    _wake.notify_one();
+    _worker.join();
+  }
+
+  // Queues `job`, which must not throw. If queueing throws, `job` is not run.
+  void submit(std::function<void()> job) {
+    {
+      std::lock_guard lock(_mutex);
+      _jobs.push_back(std::move(job));
+    }
+    _wake.notify_one();
+  }
+
+  // Blocks until every job submitted so far has finished.
+  void drain() {
+    std::unique_lock lock(_mutex);
+    _idle.wait(lock, [this] { return _jobs.empty() && !_busy; });
+  }
+
+private:
+  void run() {
+    std::unique_lock lock(_mutex);
+    while (true) {
+      _wake.wait(lock, [this] { return _stopping || !_jobs.empty(); });
+      if (_jobs.empty()) {
+        return;
+      }
+      std::function<void()> job = std::move(_jobs.front());
+      _jobs.pop_front();
+      _busy = true;
+      lock.unlock();
+      job();
+      job = nullptr;
+      lock.lock();
+      _busy = false;
+      if (_jobs.empty()) {
+        _idle.notify_all();
+      }
+    }
+  }
+
+  std::mutex _mutex;
+  std::condition_variable _wake;
+  std::condition_variable _idle;
+  std::deque<std::function<void()>> _jobs;
+  bool _busy = false;
+  bool _stopping = false;
+  // started last, once the rest is initialized
+  std::thread _worker;
+};
+
+template <typename T, typename Checking = checked, typename Compare = std::less<T>,
+          typename Allocator = std::allocator<T>>
 class set {
+  static_assert(std::is_same_v<Checking, checked> || std::is_same_v<Checking, unchecked>,
+                "Checking must be either `checked` or `unchecked`");
+
+  static constexpr bool is_checked = std::is_same_v<Checking, checked>;
+
+  // Enables the heterogeneous lookup overloads; `C` defers the check until overload resolution.
+  template <typename C>
+  static constexpr bool is_transparent = requires { typename C::is_transparent; };
+
 private:
-  class set_iterator;
+  class checked_iterator;
+  class unchecked_iterator;
+  class reverse_set_iterator;
 
-  struct base_node {
-    base_node* right;
-    base_node* left;
-    base_node* parent;
-    std::vector<set_iterator*> iterators;
+  using set_iterator = std::conditional_t<is_checked, checked_iterator, unchecked_iterator>;
+
+  struct node;
+  using node_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<node>;
+  using node_traits = std::allocator_traits<node_allocator>;
+
+  static void expects(bool condition) noexcept {
+    if (!condition) {
+      std::abort();
+    }
+  }
+
+  // Head of the intrusive list of iterators pointing to a node.
+  struct registry {
+    checked_iterator* iterators = nullptr;
 
-    base_node() : left(this), right(this), parent(this) {}
+    registry() = default;
 
-    base_node(base_node* l, base_node* r, base_node* p) : left(l), right(r), parent(p) {}
+    registry(const registry&) = delete;
+    registry& operator=(const registry&) = delete;
+
+    ~registry() {
+      invalidate();
+    }
 
-    virtual ~base_node() {
-      for (auto it : iterators) {
+    // O(k) nothrow, unlinks and invalidates every iterator to the node
+    void invalidate() noexcept {
+      while (iterators) {
+        checked_iterator* it = iterators;
+        iterators = it->next_registered;
+        it->leave_owner();
         it->is_valid = false;
+        it->prev_registered = nullptr;
+        it->next_registered = nullptr;
       }
     }
+  };
+
+  struct no_registry {};
+
+  // Head of the intrusive list of all valid iterators of a set. Iterators moving to another set together with their
+  // nodes are found through it, so handing them over costs nothing per element.
+  struct owned_iterators {
+    checked_iterator* iterators = nullptr;
+  };
+
+  struct no_owned_iterators {};
+
+  // The sentinel is the only node whose `right` points to itself; its `left` is the root of the tree.
+  struct base_node : std::conditional_t<is_checked, registry, no_registry> {
+    base_node* right;
+    base_node* left;
+    base_node* parent;
+
+    base_node() : right(this), left(nullptr), parent(this) {}
 
-    friend void swap(base_node& lhs, base_node& rhs) noexcept {
-      std::swap(lhs.left, rhs.left);
-      std::swap(lhs.right, rhs.right);
-      std::swap(lhs.parent, rhs.parent);
+    base_node(base_node* l, base_node* r, base_node* p) : right(r), left(l), parent(p) {}
+
+    bool is_sentinel() const noexcept {
+      return right == this;
     }
   };
 
+  // 32 bits are plenty for a random heap order, and a small `T` shares a word with the priority.
+  using priority = std::uint32_t;
+
   struct node : base_node {
     T value;
-    size_t key;
+    priority key;
+    // number of elements in the subtree rooted here
+    size_t size = 1;
+
+    template <typename... Args>
+    explicit node(std::in_place_t, priority key, Args&&... args)
+        : base_node(nullptr, nullptr, nullptr), value(std::forward<Args>(args)...), key(key) {}
+  };
+
+  static size_t subtree_size(const base_node* n) noexcept {
+    return n ? static_cast<const node*>(n)->size : 0;
+  }
+
+  static void update_size(base_node* n) noexcept {
+    static_cast<node*>(n)->size = 1 + subtree_size(n->left) + subtree_size(n->right);
+  }
+
+  // Recomputes the sizes from `n` up to the root of its tree, which has no parent or is a child of the sentinel.
+  static void update_sizes_up(base_node* n) noexcept {
+    for (; n && !n->is_sentinel(); n = n->parent) {
+      update_size(n);
+    }
+  }
+
+  // Adds `delta` to the sizes of `n` and its ancestors up to the sentinel.
+  static void adjust_sizes_up(base_node* n, std::ptrdiff_t delta) noexcept {
+    for (; !n->is_sentinel(); n = n->parent) {
+      static_cast<node*>(n)->size += delta;
+    }
+  }
+
+  // Number of elements before `n`; for the sentinel it is the size of the tree.
+  static size_t index_of(const base_node* n) noexcept {
+    if (n->is_sentinel()) {
+      return subtree_size(n->left);
+    }
+    size_t index = subtree_size(n->left);
+    for (const base_node* parent = n->parent; !parent->is_sentinel(); n = parent, parent = parent->parent) {
+      if (parent->right == n) {
+        index += subtree_size(parent->left) + 1;
+      }
+    }
+    return index;
+  }
+
+  // splitmix64: one word of state owned by the set, so independent sets never share a generator.
+  struct priority_generator {
+    std::uint64_t state;
+
+    priority operator()() noexcept {
+      std::uint64_t z = (state += 0x9e3779b97f4a7c15);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+      return static_cast<priority>((z ^ (z >> 31)) >> 32);
+    }
+  };
+
+  // Storage of destroyed nodes kept for reuse by later insertions. Every block is a separate one-node allocation,
+  // so a block never depends on the lifetime of another block or of the set that allocated it.
+  struct node_pool {
+    struct free_block {
+      free_block* next;
+    };
+
+    free_block* head = nullptr;
+    size_t count = 0;
+    // the number of blocks kept at most, raised by `reserve`; storage beyond it goes back to the allocator
+    size_t limit = 0;
+
+    // Keeps `storage` if there is room for it, otherwise frees it.
+    void recycle(node* storage, node_allocator& alloc) noexcept {
+      if (count < limit) {
+        push(storage);
+      } else {
+        node_traits::deallocate(alloc, storage, 1);
+      }
+    }
+
+    void push(node* storage) noexcept {
+      head = ::new (static_cast<void*>(storage)) free_block{head};
+      ++count;
+    }
+
+    node* pop() noexcept {
+      free_block* block = head;
+      head = block->next;
+      --count;
+      return static_cast<node*>(static_cast<void*>(block));
+    }
 
-    node(const T& val) : base_node(nullptr, nullptr, nullptr), value(val), key(mt()) {}
+    void splice(node_pool& other) noexcept {
+      while (other.count != 0) {
+        push(other.pop());
+      }
+    }
 
-    ~node() override = default;
+    void release(node_allocator& alloc) noexcept {
+      while (count != 0) {
+        node_traits::deallocate(alloc, pop(), 1);
+      }
+    }
   };
 
-  class set_iterator {
+  // Next node in order; the successor of the rightmost node is the sentinel.
+  static base_node* next_node(base_node* n) noexcept {
+    if (n->right) {
+      n = n->right;
+      while (n->left) {
+        n = n->left;
+      }
+      return n;
+    }
+    base_node* parent = n->parent;
+    while (n == parent->right) {
+      n = parent;
+      parent = parent->parent;
+    }
+    return parent;
+  }
+
+  // Previous node in order; the predecessor of the sentinel is the rightmost node, which the sentinel keeps as its
+  // parent. For the leftmost node the walk climbs to the sentinel, which lets the checked iterator detect
+  // `--begin()`.
+  static base_node* prev_node(base_node* n) noexcept {
+    if (n->is_sentinel()) {
+      return n->parent;
+    }
+    if (n->left) {
+      n = n->left;
+      while (n->right) {
+        n = n->right;
+      }
+      return n;
+    }
+    base_node* parent = n->parent;
+    while (n == parent->left) {
+      if (parent->is_sentinel()) {
+        return parent;
+      }
+      n = parent;
+      parent = parent->parent;
+    }
+    return parent;
+  }
+
+  class checked_iterator {
   public:
     using value_type = T;
     using difference_type = std::ptrdiff_t;
@@ -55,461 +334,2486 @@ private:
     base_node* _node;
     bool is_valid;
     const set* owner;
-
-    void vector_add() {
+    // intrusive links of the registry of `_node`, meaningful only while `is_valid`
+    checked_iterator* prev_registered = nullptr;
+    checked_iterator* next_registered = nullptr;
+    // intrusive links of the list of iterators of `owner`, meaningful only while `is_valid`
+    checked_iterator* prev_owned = nullptr;
+    checked_iterator* next_owned = nullptr;
+
+    // O(1) nothrow
+    void attach() noexcept {
       if (is_valid) {
-        _node->iterators.push_back(this);
+        enter_node();
+        join_owner();
       }
     }
 
-    void vector_del() {
+    // O(1) nothrow
+    void detach() noexcept {
       if (is_valid) {
-        auto it = std::find(_node->iterators.begin(), _node->iterators.end(), this);
-        if (it != _node->iterators.end()) {
-          _node->iterators.erase(it);
-        }
+        leave_node();
+        leave_owner();
       }
     }
 
-    void change_node(base_node* new_node) {
-      vector_del();
-      _node = new_node;
-      vector_add();
+    void enter_node() noexcept {
+      prev_registered = nullptr;
+      next_registered = _node->iterators;
+      if (next_registered) {
+        next_registered->prev_registered = this;
+      }
+      _node->iterators = this;
     }
 
-    set_iterator(base_node* node, const set* host) : _node(node), is_valid(true), owner(host) {
-      try {
-        vector_add();
-      } catch (...) {
-        is_valid = false;
-        throw;
+    void leave_node() noexcept {
+      if (prev_registered) {
+        prev_registered->next_registered = next_registered;
+      } else {
+        _node->iterators = next_registered;
+      }
+      if (next_registered) {
+        next_registered->prev_registered = prev_registered;
+      }
+      prev_registered = nullptr;
+      next_registered = nullptr;
+    }
+
+    void join_owner() noexcept {
+      prev_owned = nullptr;
+      next_owned = owner->_owned.iterators;
+      if (next_owned) {
+        next_owned->prev_owned = this;
+      }
+      owner->_owned.iterators = this;
+    }
+
+    void leave_owner() noexcept {
+      if (prev_owned) {
+        prev_owned->next_owned = next_owned;
+      } else {
+        owner->_owned.iterators = next_owned;
+      }
+      if (next_owned) {
+        next_owned->prev_owned = prev_owned;
+      }
+      prev_owned = nullptr;
+      next_owned = nullptr;
+    }
+
+    void change_node(base_node* new_node) noexcept {
+      if (is_valid) {
+        leave_node();
+        _node = new_node;
+        enter_node();
+      } else {
+        _node = new_node;
+      }
+    }
+
+    // O(1) nothrow, puts this iterator where `other` is in the registry of the node and in the list of the owner,
+    // touching only the neighbours; `_node`, `is_valid` and `owner` must already be copied from `other`
+    void take_slot(checked_iterator& other) noexcept {
+      if (!is_valid) {
+        return;
+      }
+      prev_registered = std::exchange(other.prev_registered, nullptr);
+      next_registered = std::exchange(other.next_registered, nullptr);
+      (prev_registered ? prev_registered->next_registered : _node->iterators) = this;
+      if (next_registered) {
+        next_registered->prev_registered = this;
+      }
+      prev_owned = std::exchange(other.prev_owned, nullptr);
+      next_owned = std::exchange(other.next_owned, nullptr);
+      (prev_owned ? prev_owned->next_owned : owner->_owned.iterators) = this;
+      if (next_owned) {
+        next_owned->prev_owned = this;
       }
+      other.is_valid = false;
+    }
+
+    // Makes an iterator built in place, e.g. inside a returned pair, a valid iterator to `node` of `host`.
+    void point_to(base_node* node, const set* host) noexcept {
+      detach();
+      _node = node;
+      is_valid = true;
+      owner = host;
+      attach();
+    }
+
+    checked_iterator(base_node* node, const set* host) noexcept : _node(node), is_valid(true), owner(host) {
+      attach();
     }
+
     friend class set;
 
   public:
-    set_iterator() : _node(nullptr), is_valid(false), owner(nullptr) {}
+    checked_iterator() noexcept : _node(nullptr), is_valid(false), owner(nullptr) {}
 
-    set_iterator(const set_iterator& other) : _node(other._node), is_valid(other.is_valid), owner(other.owner) {
-      try {
-        vector_add();
-      } catch (...) {
-        is_valid = false;
-        throw;
-      }
+    checked_iterator(const checked_iterator& other) noexcept
+        : _node(other._node), is_valid(other.is_valid), owner(other.owner) {
+      attach();
     }
 
-    set_iterator& operator=(const set_iterator& other) {
+    checked_iterator& operator=(const checked_iterator& other) noexcept {
       if (this != &other) {
-        vector_del();
-
+        detach();
         _node = other._node;
         is_valid = other.is_valid;
         owner = other.owner;
+        attach();
+      }
+      return *this;
+    }
 
-        try {
-          vector_add();
-        } catch (...) {
-          is_valid = false;
-          throw;
-        }
+    // Takes over the place of `other` in both lists, leaving it singular like a default-constructed iterator.
+    checked_iterator(checked_iterator&& other) noexcept
+        : _node(other._node), is_valid(other.is_valid), owner(other.owner) {
+      take_slot(other);
+    }
+
+    checked_iterator& operator=(checked_iterator&& other) noexcept {
+      if (this != &other) {
+        detach();
+        _node = other._node;
+        is_valid = other.is_valid;
+        owner = other.owner;
+        take_slot(other);
       }
       return *this;
     }
 
-    ~set_iterator() {
-      vector_del();
+    ~checked_iterator() {
+      detach();
     }
 
     reference operator*() const {
-      assert(is_valid);
-      assert(_node != _node->right);
+      expects(is_valid);
+      expects(!_node->is_sentinel());
       return static_cast<node*>(_node)->value;
     }
 
     pointer operator->() const {
-      assert(is_valid);
-      assert(_node != _node->right);
+      expects(is_valid);
+      expects(!_node->is_sentinel());
       return &(static_cast<node*>(_node)->value);
     }
 
-    set_iterator& operator++() {
-      assert(is_valid);
-      assert(_node != _node->right);
-      if (_node->right) {
-        change_node(_node->right);
-        while (_node->left != nullptr && _node->left != _node) {
-          change_node(_node->left);
-        }
-      } else {
-        base_node* parent = _node->parent;
-        while (_node->parent != nullptr && _node == parent->right) {
-          change_node(parent);
-          parent = parent->parent;
-        }
-        change_node(parent);
-      }
+    // The walk runs on raw pointers; only the final node is registered.
+    checked_iterator& operator++() {
+      expects(is_valid);
+      expects(!_node->is_sentinel());
+      change_node(next_node(_node));
       return *this;
     }
 
-    set_iterator& operator--() {
-      assert(is_valid);
-      if (_node->left != nullptr && _node->left != _node) {
-        change_node(_node->left);
-        while (_node->right != nullptr && _node->right != _node) {
-          change_node(_node->right);
-        }
-      } else {
-        base_node* parent = _node->parent;
-        while (parent != nullptr && _node == parent->left && _node != parent->right) {
-          change_node(parent);
-          parent = parent->parent;
-        }
-        change_node(parent);
-      }
-      assert(_node != _node->right);
+    checked_iterator& operator--() {
+      expects(is_valid);
+      base_node* prev = prev_node(_node);
+      expects(!prev->is_sentinel());
+      change_node(prev);
       return *this;
     }
 
-    set_iterator operator++(int) {
-      set_iterator tmp = *this;
+    checked_iterator operator++(int) {
+      checked_iterator tmp = *this;
       ++(*this);
       return tmp;
     }
 
-    set_iterator operator--(int) {
-      set_iterator tmp = *this;
+    checked_iterator operator--(int) {
+      checked_iterator tmp = *this;
       --(*this);
       return tmp;
     }
 
-    bool operator==(const set_iterator& other) const {
-      assert(is_valid);
-      assert(other.is_valid);
-      assert(owner == other.owner);
+    bool operator==(const checked_iterator& other) const {
+      expects(is_valid);
+      expects(other.is_valid);
+      expects(owner == other.owner);
       return _node == other._node;
     }
 
-    bool operator!=(const set_iterator& other) const {
-      assert(is_valid);
-      assert(other.is_valid);
-      assert(owner == other.owner);
-      return _node != other._node;
+    bool operator!=(const checked_iterator& other) const {
+      return !(*this == other);
     }
 
-    friend void swap(set_iterator& left, set_iterator& right) {
-      assert(left.is_valid);
-      assert(right.is_valid);
-
-      assert(left._node != right._node);
-      assert(left._node != left._node->right);
-      assert(right._node != right._node->right);
+    // O(h), from the subtree sizes; makes `std::ranges::distance` logarithmic
+    friend difference_type operator-(const checked_iterator& last, const checked_iterator& first) {
+      return last.distance_from(first);
+    }
 
-      base_node* left_node = left._node;
-      base_node* right_node = right._node;
+    // O(h), found by argument-dependent lookup
+    friend difference_type distance(const checked_iterator& first, const checked_iterator& last) {
+      return last - first;
+    }
 
-      std::swap(left._node, right._node);
-      std::swap(left.owner, right.owner);
+    friend void swap(checked_iterator& left, checked_iterator& right) {
+      left.swap(right);
+    }
 
-      for (auto it : left_node->iterators) {
-        it->_node = left_node;
-      }
-      for (auto it : right_node->iterators) {
-        it->_node = right_node;
-      }
+  private:
+    difference_type distance_from(const checked_iterator& first) const {
+      expects(is_valid);
+      expects(first.is_valid);
+      expects(owner == first.owner);
+      return static_cast<difference_type>(index_of(_node)) - static_cast<difference_type>(index_of(first._node));
     }
-  };
 
-public:
-  using value_type = T;
+    void swap(checked_iterator& other) {
+      expects(is_valid);
+      expects(other.is_valid);
 
-  using reference = T&;
-  using const_reference = const T&;
+      expects(_node != other._node);
+      expects(!_node->is_sentinel());
+      expects(!other._node->is_sentinel());
 
-  using pointer = T*;
-  using const_pointer = const T*;
+      detach();
+      other.detach();
+      std::swap(_node, other._node);
+      std::swap(owner, other.owner);
+      attach();
+      other.attach();
+    }
+  };
 
-  using iterator = set_iterator;
-  using const_iterator = set_iterator;
+  class unchecked_iterator {
+  public:
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using reference = const T&;
+    using pointer = const T*;
+    using iterator_category = std::bidirectional_iterator_tag;
 
-  using reverse_iterator = std::reverse_iterator<iterator>;
-  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+  private:
+    base_node* _node = nullptr;
 
-public:
-  // O(1) nothrow
-  set() noexcept : _root(base_node()) {}
+    unchecked_iterator(base_node* node, const set*) noexcept : _node(node) {}
 
-  // O(n) strong
-  set(const set& other) : set() {
-    for (auto t = other.begin(); t != other.end(); t++) {
-      insert(*t);
+    void point_to(base_node* node, const set*) noexcept {
+      _node = node;
     }
-  }
 
-  // O(n) strong
-  set& operator=(const set& other) {
-    if (this != &other) {
-      set temp(other);
-      swap(*this, temp);
+    void change_node(base_node* new_node) noexcept {
+      _node = new_node;
     }
-    return *this;
-  }
 
-  // O(n) nothrow
-  ~set() noexcept {
-    if (empty()) {
-      return;
+    friend class set;
+
+  public:
+    unchecked_iterator() noexcept = default;
+
+    reference operator*() const noexcept {
+      return static_cast<node*>(_node)->value;
     }
-    deleting(_root.left);
-  }
 
-  // O(n) nothrow
-  void clear() noexcept {
-    if (empty()) {
-      return;
+    pointer operator->() const noexcept {
+      return &(static_cast<node*>(_node)->value);
     }
-    deleting(_root.left);
-    _size = 0;
-  }
 
-  // O(1) nothrow
-  size_t size() const noexcept {
-    return _size;
-  }
+    unchecked_iterator& operator++() noexcept {
+      _node = next_node(_node);
+      return *this;
+    }
 
-  // O(1) nothrow
-  bool empty() const noexcept {
-    return size() == 0;
-  }
+    unchecked_iterator& operator--() noexcept {
+      _node = prev_node(_node);
+      return *this;
+    }
 
-  // nothrow
-  const_iterator begin() const {
-    if (empty()) {
-      return end();
+    unchecked_iterator operator++(int) noexcept {
+      unchecked_iterator tmp = *this;
+      ++(*this);
+      return tmp;
     }
-    return const_iterator(most_left(_root.left), this);
-  }
 
-  // nothrow
-  const_iterator end() const {
-    return const_iterator(const_cast<base_node*>(&_root), this);
-  }
+    unchecked_iterator operator--(int) noexcept {
+      unchecked_iterator tmp = *this;
+      --(*this);
+      return tmp;
+    }
 
-  // nothrow
-  const_reverse_iterator rbegin() const {
-    return reverse_iterator(end());
-  }
+    bool operator==(const unchecked_iterator& other) const noexcept {
+      return _node == other._node;
+    }
 
-  // nothrow
-  const_reverse_iterator rend() const {
-    return reverse_iterator(begin());
-  }
+    bool operator!=(const unchecked_iterator& other) const noexcept {
+      return _node != other._node;
+    }
 
-  // O(h) strong
-  std::pair<iterator, bool> insert(const T& value) {
-    node* new_node = nullptr;
-    iterator it;
-    if (empty()) {
-      try {
-        new_node = new node(value);
-        it = iterator(new_node, this);
-      } catch (...) {
-        delete new_node;
-        throw;
-      }
-      _root.left = new_node;
-      new_node->parent = &_root;
-      _size++;
-      return {iterator(new_node, this), true};
+    // O(h), from the subtree sizes; makes `std::ranges::distance` logarithmic
+    friend difference_type operator-(const unchecked_iterator& last, const unchecked_iterator& first) noexcept {
+      return last.distance_from(first);
     }
-    node* try_find = find(_root.left, value);
-    if (try_find) {
-      return {iterator(try_find, this), false};
+
+    // O(h), found by argument-dependent lookup
+    friend difference_type distance(const unchecked_iterator& first, const unchecked_iterator& last) noexcept {
+      return last - first;
     }
-    base_node* left = nullptr;
-    base_node* right = nullptr;
 
-    try {
-      new_node = new node(value);
-      it = iterator(new_node, this);
-    } catch (...) {
-      delete new_node;
-      throw;
+  private:
+    difference_type distance_from(const unchecked_iterator& first) const noexcept {
+      return static_cast<difference_type>(index_of(_node)) - static_cast<difference_type>(index_of(first._node));
     }
+  };
 
-    split(_root.left, value, left, right);
+  // Points directly at its element, unlike `std::reverse_iterator`, which keeps an iterator to the next element and
+  // steps back from it on every dereference. The sentinel stands for `rend()`. In the checked mode it is registered
+  // on its node like a forward iterator, so it is invalidated in the same way.
+  class reverse_set_iterator {
+  public:
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using reference = const T&;
+    using pointer = const T*;
+    using iterator_category = std::bidirectional_iterator_tag;
 
-    auto root = merge(merge(left, new_node), right);
-    root->parent = &_root;
-    _root.left = root;
-    _size++;
-    return {it, true};
-  }
+  private:
+    set_iterator _it;
 
-  // O(h) nothrow
-  iterator erase(const_iterator pos) {
-    assert(pos.is_valid);
-    assert(pos.owner == this);
-    assert(pos._node != &_root);
+    reverse_set_iterator(base_node* node, const set* host) noexcept : _it(node, host) {}
 
-    _size--;
-    auto this_node = pos._node;
-    pos++;
+    friend class set;
 
-    auto kids = merge(this_node->left, this_node->right);
+  public:
+    reverse_set_iterator() noexcept = default;
 
-    if (this_node == &_root) {
-      kids->parent = &_root;
-      _root.left = kids;
-    } else {
-      if (this_node->parent->left == this_node) {
-        this_node->parent->left = kids;
-      } else {
-        this_node->parent->right = kids;
+    // O(h), the element before `it`, as `std::reverse_iterator(it)` would show it
+    explicit reverse_set_iterator(const set_iterator& it) noexcept(!is_checked) : _it(it) {
+      if constexpr (is_checked) {
+        expects(_it.is_valid);
       }
-      if (kids) {
-        kids->parent = this_node->parent;
+      _it.change_node(prev_node(_it._node));
+    }
+
+    // O(h), the iterator to the element after this one; `rend().base()` is `begin()`
+    set_iterator base() const noexcept(!is_checked) {
+      if constexpr (is_checked) {
+        expects(_it.is_valid);
+      }
+      set_iterator result = _it;
+      result.change_node(next_node(_it._node));
+      return result;
+    }
+
+    reference operator*() const noexcept(!is_checked) {
+      return *_it;
+    }
+
+    pointer operator->() const noexcept(!is_checked) {
+      return _it.operator->();
+    }
+
+    reverse_set_iterator& operator++() noexcept(!is_checked) {
+      if constexpr (is_checked) {
+        expects(_it.is_valid);
+        expects(!_it._node->is_sentinel());
+      }
+      _it.change_node(prev_node(_it._node));
+      return *this;
+    }
+
+    reverse_set_iterator& operator--() noexcept(!is_checked) {
+      if constexpr (is_checked) {
+        expects(_it.is_valid);
+      }
+      base_node* next = next_node(_it._node);
+      if constexpr (is_checked) {
+        expects(!next->is_sentinel());
+      }
+      _it.change_node(next);
+      return *this;
+    }
+
+    reverse_set_iterator operator++(int) noexcept(!is_checked) {
+      reverse_set_iterator tmp = *this;
+      ++(*this);
+      return tmp;
+    }
+
+    reverse_set_iterator operator--(int) noexcept(!is_checked) {
+      reverse_set_iterator tmp = *this;
+      --(*this);
+      return tmp;
+    }
+
+    bool operator==(const reverse_set_iterator& other) const noexcept(!is_checked) {
+      return _it == other._it;
+    }
+
+    bool operator!=(const reverse_set_iterator& other) const noexcept(!is_checked) {
+      return _it != other._it;
+    }
+
+    // O(h), from the subtree sizes
+    friend difference_type operator-(const reverse_set_iterator& last,
+                                     const reverse_set_iterator& first) noexcept(!is_checked) {
+      return last.distance_from(first);
+    }
+
+    // O(h), found by argument-dependent lookup
+    friend difference_type distance(const reverse_set_iterator& first,
+                                    const reverse_set_iterator& last) noexcept(!is_checked) {
+      return last - first;
+    }
+
+  private:
+    difference_type distance_from(const reverse_set_iterator& first) const noexcept(!is_checked) {
+      if constexpr (is_checked) {
+        expects(_it.is_valid);
+        expects(first._it.is_valid);
+        expects(_it.owner == first._it.owner);
+      }
+      return first.position() - position();
+    }
+
+    // index of the element in the forward order, -1 for `rend()`
+    difference_type position() const noexcept {
+      return _it._node->is_sentinel() ? -1 : static_cast<difference_type>(index_of(_it._node));
+    }
+  };
+
+  // Owns an extracted node together with a copy of the allocator that frees it. The node keeps its priority, so
+  // inserting it again allocates nothing and copies nothing.
+  class node_handle {
+  public:
+    using value_type = T;
+    using allocator_type = Allocator;
+
+  private:
+    node* _node = nullptr;
+    std::optional<node_allocator> _alloc;
+
+    node_handle(node* n, const node_allocator& alloc) noexcept : _node(n), _alloc(alloc) {}
+
+    // Hands the node over to a set, leaving the handle empty.
+    node* release() noexcept {
+      _alloc.reset();
+      return std::exchange(_node, nullptr);
+    }
+
+    void reset() noexcept {
+      if (_node) {
+        node_traits::destroy(*_alloc, _node);
+        node_traits::deallocate(*_alloc, _node, 1);
+        _node = nullptr;
+      }
+      _alloc.reset();
+    }
+
+    // allocators need not be assignable, so they are moved by reconstruction
+    void take(node_handle& other) noexcept {
+      _node = std::exchange(other._node, nullptr);
+      if (other._alloc) {
+        _alloc.emplace(std::move(*other._alloc));
+        other._alloc.reset();
+      }
+    }
+
+    friend class set;
+
+  public:
+    node_handle() noexcept = default;
+
+    node_handle(node_handle&& other) noexcept {
+      take(other);
+    }
+
+    node_handle& operator=(node_handle&& other) noexcept {
+      if (this != &other) {
+        reset();
+        take(other);
+      }
+      return *this;
+    }
+
+    ~node_handle() {
+      reset();
+    }
+
+    bool empty() const noexcept {
+      return _node == nullptr;
+    }
+
+    explicit operator bool() const noexcept {
+      return !empty();
+    }
+
+    value_type& value() const {
+      if constexpr (is_checked) {
+        expects(!empty());
+      }
+      return _node->value;
+    }
+
+    allocator_type get_allocator() const {
+      if constexpr (is_checked) {
+        expects(!empty());
+      }
+      return allocator_type(*_alloc);
+    }
+
+    friend void swap(node_handle& left, node_handle& right) noexcept {
+      node_handle tmp(std::move(left));
+      left = std::move(right);
+      right = std::move(tmp);
+    }
+  };
+
+public:
+  using key_type = T;
+  using value_type = T;
+  using key_compare = Compare;
+  using value_compare = Compare;
+  using allocator_type = Allocator;
+
+  using reference = T&;
+  using const_reference = const T&;
+
+  using pointer = T*;
+  using const_pointer = const T*;
+
+  using iterator = set_iterator;
+  using const_iterator = set_iterator;
+
+  using reverse_iterator = reverse_set_iterator;
+  using const_reverse_iterator = reverse_set_iterator;
+
+  using node_type = node_handle;
+
+  struct insert_return_type {
+    iterator position;
+    bool inserted;
+    node_type node;
+  };
+
+public:
+  // O(1) nothrow
+  set() noexcept(noexcept(Compare()) && noexcept(Allocator())) : set(Compare()) {}
+
+  // O(1) strong
+  explicit set(const Compare& comp, const Allocator& alloc = Allocator())
+      : _comp(comp), _alloc(alloc), _priorities{reinterpret_cast<std::uintptr_t>(this)} {}
+
+  // O(1) nothrow
+  explicit set(const Allocator& alloc) noexcept(noexcept(Compare())) : set(Compare(), alloc) {}
+
+  // O(n) for sorted input, O(n log n) otherwise; strong
+  template <std::input_iterator InputIt>
+  set(InputIt first, InputIt last, const Compare& comp = Compare(), const Allocator& alloc = Allocator())
+      : set(comp, alloc) {
+    build(first, last);
+  }
+
+  // O(n) for sorted input, O(n log n) otherwise; strong
+  set(std::initializer_list<T> init, const Compare& comp = Compare(), const Allocator& alloc = Allocator())
+      : set(init.begin(), init.end(), comp, alloc) {}
+
+  // O(n) strong
+  set(const set& other) : set(other, node_traits::select_on_container_copy_construction(other._alloc)) {}
+
+  // O(n) strong
+  set(const set& other, const Allocator& alloc) : set(other._comp, alloc) {
+    set_root(clone_tree(other._root.left));
+    _size = other._size;
+    _priorities = other._priorities;
+  }
+
+  // O(1) nothrow, plus O(k) in the checked mode to hand over the k iterators of `other`, which then refer to this set;
+  // `other` is left empty
+  set(set&& other) noexcept(std::is_nothrow_copy_constructible_v<Compare>)
+      : set(other._comp, Allocator(other._alloc)) {
+    using std::swap;
+    swap(_pool, other._pool);
+    swap_trees(other);
+    _priorities = other._priorities;
+    _reclaimer = other._reclaimer;
+  }
+
+  // O(1) nothrow, plus the destruction of the old elements and O(k) in the checked mode for the iterators, if the
+  // allocator propagates or the allocators are equal; otherwise the elements are moved one by one into new nodes,
+  // O(n) basic, and `other` is left empty
+  set& operator=(set&& other) noexcept((node_traits::propagate_on_container_move_assignment::value ||
+                                        node_traits::is_always_equal::value) &&
+                                       std::is_nothrow_copy_constructible_v<Compare>) {
+    if (this != &other) {
+      constexpr bool propagate = node_traits::propagate_on_container_move_assignment::value;
+      if (propagate || _alloc == other._alloc) {
+        set temp(std::move(other));
+        swap_trees(temp);
+        if constexpr (propagate) {
+          swap_storage(temp);
+        }
+      } else if constexpr (!node_traits::is_always_equal::value) {
+        set temp(other._comp, Allocator(_alloc));
+        temp.set_root(temp.clone_tree<true>(other._root.left));
+        temp._size = other._size;
+        temp._priorities = other._priorities;
+        swap_trees(temp);
+        other.clear();
+      }
+    }
+    return *this;
+  }
+
+  // O(n + m) strong
+  // Reuses the nodes of this set, as `assign` does, when assigning a `T` cannot throw; otherwise builds a copy first.
+  set& operator=(const set& other) {
+    if (this != &other) {
+      if constexpr (std::is_nothrow_copy_assignable_v<T>) {
+        if (can_reuse_nodes_for(other)) {
+          assign_reusing_nodes(other);
+          return *this;
+        }
+      }
+      copy_and_swap(other);
+    }
+    return *this;
+  }
+
+  // O(n + m) basic, strong if assigning a `T` does not throw
+  // Copies `other` into the existing nodes: the values are assigned over the old ones and the nodes are relinked in
+  // the shape of `other`, so only the difference in size is allocated, or released as by `erase`. Iterators to the old
+  // elements are invalidated. If an assignment throws, the set is left empty.
+  void assign(const set& other) {
+    if (this == &other) {
+      return;
+    }
+    if (can_reuse_nodes_for(other)) {
+      assign_reusing_nodes(other);
+    } else {
+      copy_and_swap(other);
+    }
+  }
+
+  // O(n) nothrow, or O(k) for the k iterators of the set with a reclaimer
+  ~set() noexcept {
+    dispose(std::exchange(_root.left, nullptr), false);
+    _pool.release(_alloc);
+  }
+
+  // O(n) nothrow, keeps the storage of the removed nodes for reuse up to the capacity requested by `reserve` and
+  // frees the rest; or O(k) for the k iterators of the set with a reclaimer, which frees the storage instead
+  void clear() noexcept {
+    if (empty()) {
+      return;
+    }
+    dispose(std::exchange(_root.left, nullptr), true);
+    set_root(nullptr);
+    _size = 0;
+  }
+
+  // O(1) nothrow
+  // From now on `clear()`, the destructor and range erases detach the removed nodes and leave destroying them to
+  // `reclaimer`, which then runs the destructors of the elements on its thread and frees the nodes through a copy of
+  // the allocator, so the allocator has to be usable from there. A null pointer restores the synchronous behaviour.
+  void reclaim_with(background_reclaimer* reclaimer) noexcept {
+    _reclaimer = reclaimer;
+  }
+
+  // O(n) strong
+  // Preallocates node storage so that the set can hold `n` elements without calling the allocator. From then on up
+  // to `n` blocks of the storage of removed elements are kept for reuse instead of being freed.
+  void reserve(size_t n) {
+    if (n > capacity()) {
+      node_pool extra;
+      try {
+        for (size_t i = capacity(); i < n; ++i) {
+          extra.push(node_traits::allocate(_alloc, 1));
+        }
+      } catch (...) {
+        extra.release(_alloc);
+        throw;
+      }
+      _pool.splice(extra);
+    }
+    _pool.limit = std::max(_pool.limit, n);
+  }
+
+  // O(1) nothrow
+  size_t capacity() const noexcept {
+    return _size + _pool.count;
+  }
+
+  // O(k) nothrow
+  // Returns the storage kept for reuse to the allocator and stops keeping it until the next `reserve`.
+  void shrink_to_fit() noexcept {
+    _pool.release(_alloc);
+    _pool.limit = 0;
+  }
+
+  // O(1) nothrow
+  allocator_type get_allocator() const noexcept {
+    return allocator_type(_alloc);
+  }
+
+  // O(1) strong
+  key_compare key_comp() const {
+    return _comp;
+  }
+
+  // O(1) strong
+  value_compare value_comp() const {
+    return _comp;
+  }
+
+  // O(1) nothrow
+  size_t size() const noexcept {
+    return _size;
+  }
+
+  // O(1) nothrow
+  bool empty() const noexcept {
+    return size() == 0;
+  }
+
+  // O(1) nothrow
+  const_iterator begin() const noexcept {
+    return const_iterator(_leftmost, this);
+  }
+
+  // O(1) nothrow
+  // Refers to an iterator kept by the set, so comparing with `end()` registers nothing; copies of it are ordinary
+  // iterators.
+  const const_iterator& end() const noexcept {
+    return _end;
+  }
+
+  // O(1) nothrow
+  const_reverse_iterator rbegin() const noexcept {
+    return const_reverse_iterator(_root.parent, this);
+  }
+
+  // O(1) nothrow, registers nothing like `end()`
+  const const_reverse_iterator& rend() const noexcept {
+    return _rend;
+  }
+
+  // O(1) nothrow
+  const T& front() const noexcept {
+    if constexpr (is_checked) {
+      expects(!empty());
+    }
+    return static_cast<const node*>(_leftmost)->value;
+  }
+
+  // O(1) nothrow
+  const T& back() const noexcept {
+    if constexpr (is_checked) {
+      expects(!empty());
+    }
+    return static_cast<const node*>(_root.parent)->value;
+  }
+
+  // O(h) nothrow: the relinking is O(1), the subtree sizes of the ancestors are updated
+  void pop_front() noexcept {
+    if constexpr (is_checked) {
+      expects(!empty());
+    }
+    remove_node(_leftmost);
+  }
+
+  // O(h) nothrow: the relinking is O(1), the subtree sizes of the ancestors are updated
+  void pop_back() noexcept {
+    if constexpr (is_checked) {
+      expects(!empty());
+    }
+    remove_node(_root.parent);
+  }
+
+  // O(h) strong
+  std::pair<iterator, bool> insert(const T& value) {
+    return insert_unique(value);
+  }
+
+  // O(h) strong
+  std::pair<iterator, bool> insert(T&& value) {
+    return insert_unique(std::move(value));
+  }
+
+  // O(h) strong
+  // The value is constructed in place before the search; if an equivalent element exists, the new node is destroyed.
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args) {
+    return emplace_node(create_node(std::forward<Args>(args)...));
+  }
+
+  // O(h) strong, for the subtree sizes up to the root; if the value belongs right before or right after `hint`, the
+  // search is skipped and only O(1) comparisons are made
+  iterator insert(const_iterator hint, const T& value) {
+    return insert_hinted(hint, value);
+  }
+
+  // O(h) strong, for the subtree sizes up to the root; if the value belongs right before or right after `hint`, the
+  // search is skipped and only O(1) comparisons are made
+  iterator insert(const_iterator hint, T&& value) {
+    return insert_hinted(hint, std::move(value));
+  }
+
+  // O(h) strong, for the subtree sizes up to the root; if the value belongs right before or right after `hint`, the
+  // search is skipped and only O(1) comparisons are made
+  template <typename... Args>
+  iterator emplace_hint(const_iterator hint, Args&&... args) {
+    if constexpr (is_checked) {
+      expects(hint.is_valid);
+      expects(hint.owner == this);
+    }
+    node* new_node = create_node(std::forward<Args>(args)...);
+    base_node* prev = nullptr;
+    base_node* next = nullptr;
+    node* existing = nullptr;
+    bool near = false;
+    try {
+      near = locate_near(hint._node, new_node->value, prev, next, existing);
+    } catch (...) {
+      destroy_node(new_node);
+      throw;
+    }
+    if (!near) {
+      return emplace_node(new_node).first;
+    }
+    if (existing) {
+      destroy_node(new_node);
+      return iterator(existing, this);
+    }
+    return attach_between(prev, next, new_node);
+  }
+
+  // O(m) if the set is empty or the range lies entirely before or after its elements, O(m log(n + m)) otherwise;
+  // basic
+  template <std::input_iterator InputIt>
+  void insert(InputIt first, InputIt last) {
+    if (empty()) {
+      build(first, last);
+      return;
+    }
+    set range(first, last, _comp, Allocator(_alloc));
+    if (range.empty()) {
+      return;
+    }
+    base_node* root = nullptr;
+    if (_comp(max_value(), range.min_value())) {
+      root = merge(_root.left, range._root.left);
+    } else if (_comp(range.max_value(), min_value())) {
+      root = merge(range._root.left, _root.left);
+    } else {
+      for (base_node* n = range._leftmost; n != &range._root; n = next_node(n)) {
+        insert_unique(std::move(static_cast<node*>(n)->value));
+      }
+      return;
+    }
+    set_root(root);
+    _size += std::exchange(range._size, 0);
+    range.set_root(nullptr);
+  }
+
+  // O(m) if the set is empty or the list lies entirely before or after its elements, O(m log(n + m)) otherwise;
+  // basic
+  void insert(std::initializer_list<T> init) {
+    insert(init.begin(), init.end());
+  }
+
+  // O(h) nothrow
+  iterator erase(const_iterator pos) {
+    if constexpr (is_checked) {
+      expects(pos.is_valid);
+      expects(pos.owner == this);
+      expects(pos._node != &_root);
+    }
+
+    auto this_node = pos._node;
+    pos++;
+    remove_node(this_node);
+    return pos;
+  }
+
+  // O(h) strong
+  // Locates and unlinks the element in one descent without creating an iterator.
+  size_t erase(const T& value) {
+    base_node** candidate_link = nullptr;
+    base_node** link = &_root.left;
+    while (*link) {
+      node* current = static_cast<node*>(*link);
+      if (_comp(current->value, value)) {
+        link = &current->right;
+      } else {
+        candidate_link = link;
+        link = &current->left;
+      }
+    }
+    if (!candidate_link || _comp(value, static_cast<node*>(*candidate_link)->value)) {
+      return 0;
+    }
+    base_node* target = *candidate_link;
+    forget_extreme(target);
+    base_node* kids = merge(target->left, target->right);
+    *candidate_link = kids;
+    if (kids) {
+      kids->parent = target->parent;
+    }
+    adjust_sizes_up(target->parent, -1);
+    _size--;
+    destroy_node(target);
+    return 1;
+  }
+
+  // O(h + k) nothrow, k being the number of erased elements
+  // Detaches `[first, last)` by positions and destroys it, invalidating the iterators to the erased elements.
+  iterator erase(const_iterator first, const_iterator last) {
+    if constexpr (is_checked) {
+      expects(first.is_valid);
+      expects(last.is_valid);
+      expects(first.owner == this);
+      expects(last.owner == this);
+    }
+    size_t from = index_of(first._node);
+    size_t to = index_of(last._node);
+    if constexpr (is_checked) {
+      expects(from <= to);
+    }
+    erase_positions(from, to);
+    return last;
+  }
+
+  // O(h + k) strong, k being the number of erased elements
+  // Erases the elements in `[lo, hi)` and returns their number; nothing is erased unless `lo` is less than `hi`.
+  size_t erase_range(const T& lo, const T& hi) {
+    return erase_range_of(lo, hi);
+  }
+
+  // O(h + k) strong, k being the number of erased elements
+  template <typename K, typename C = Compare>
+  requires is_transparent<C>
+  size_t erase_range(const K& lo, const K& hi) {
+    return erase_range_of(lo, hi);
+  }
+
+  // O(h) nothrow
+  // Unlinks the element at `pos` without destroying it. Iterators to it are invalidated as by `erase`.
+  node_type extract(const_iterator pos) noexcept {
+    if constexpr (is_checked) {
+      expects(pos.is_valid);
+      expects(pos.owner == this);
+      expects(!pos._node->is_sentinel());
+    }
+    return extract_node(pos._node);
+  }
+
+  // O(h) strong
+  // Unlinks the element equivalent to `value`, if any; otherwise the returned handle is empty.
+  node_type extract(const T& value) {
+    return extract_of(value);
+  }
+
+  // O(h) strong
+  template <typename K, typename C = Compare>
+  requires is_transparent<C>
+  node_type extract(const K& key) {
+    return extract_of(key);
+  }
+
+  // O(h) strong
+  // Links the node of `nh` into the set without allocating or copying. If an equivalent element exists, the node
+  // stays in the returned handle and `position` points to that element.
+  insert_return_type insert(node_type&& nh) {
+    if (nh.empty()) {
+      return {end(), false, node_type()};
+    }
+    if constexpr (is_checked && !node_traits::is_always_equal::value) {
+      expects(*nh._alloc == _alloc);
+    }
+    insert_position pos = locate_insert(nh._node->value, nh._node->key);
+    if (pos.existing) {
+      return {iterator(pos.existing, this), false, std::move(nh)};
+    }
+    return {iterator(place_node(pos, nh.release()), this), true, node_type()};
+  }
+
+  // O(m h) basic
+  // Relinks every element of `source` that has no equivalent here into this set; the rest stay in `source`.
+  // Iterators to the moved elements stay valid and now refer to this set.
+  void merge(set& source) {
+    if constexpr (is_checked && !node_traits::is_always_equal::value) {
+      expects(_alloc == source._alloc);
+    }
+    if (this == &source) {
+      return;
+    }
+    base_node* n = source._leftmost;
+    while (n != &source._root) {
+      base_node* next = next_node(n);
+      insert_position pos = locate_insert(static_cast<node*>(n)->value, static_cast<node*>(n)->key);
+      if (!pos.existing) {
+        source.unlink_node(n);
+        if constexpr (is_checked) {
+          adopt_iterators(n);
+        }
+        place_node(pos, static_cast<node*>(n));
+      }
+      n = next;
+    }
+  }
+
+  // O(m h) basic
+  void merge(set&& source) {
+    merge(source);
+  }
+
+  // O(h) strong
+  const_iterator lower_bound(const T& value) const {
+    return lower_bound_of(value);
+  }
+
+  // O(h) strong
+  template <typename K, typename C = Compare>
+  requires is_transparent<C>
+  const_iterator lower_bound(const K& key) const {
+    return lower_bound_of(key);
+  }
+
+  // O(h) strong
+  const_iterator upper_bound(const T& value) const {
+    return upper_bound_of(value);
+  }
+
+  // O(h) strong
+  template <typename K, typename C = Compare>
+  requires is_transparent<C>
+  const_iterator upper_bound(const K& key) const {
+    return upper_bound_of(key);
+  }
+
+  // O(h) strong
+  const_iterator find(const T& value) const {
+    return find_of(value);
+  }
+
+  // O(h) strong
+  template <typename K, typename C = Compare>
+  requires is_transparent<C>
+  const_iterator find(const K& key) const {
+    return find_of(key);
+  }
+
+  // O(h) strong
+  size_t count(const T& value) const {
+    return find(_root.left, value) ? 1 : 0;
+  }
+
+  // O(h) strong
+  template <typename K, typename C = Compare>
+  requires is_transparent<C>
+  size_t count(const K& key) const {
+    return find(_root.left, key) ? 1 : 0;
+  }
+
+  // O(h) strong
+  bool contains(const T& value) const {
+    return find(_root.left, value) != nullptr;
+  }
+
+  // O(h) strong
+  template <typename K, typename C = Compare>
+  requires is_transparent<C>
+  bool contains(const K& key) const {
+    return find(_root.left, key) != nullptr;
+  }
+
+  // O(k h) strong
+  // Looks up `keys[i]` into `results[i]`, which must have room for all of them. The descents of a group of keys
+  // advance in lockstep and prefetch their next nodes, so the cache misses of different keys overlap.
+  void find_many(std::span<const T> keys, std::span<const_iterator> results) const {
+    find_many_of(keys, results);
+  }
+
+  // O(k h) strong
+  // `keys` is any contiguous range, so that the key type is deduced from it, e.g. a `std::vector<std::string_view>`.
+  template <std::ranges::contiguous_range Keys, typename C = Compare>
+  requires is_transparent<C>
+  void find_many(const Keys& keys, std::span<const_iterator> results) const {
+    find_many_of(std::span<const std::ranges::range_value_t<Keys>>(keys), results);
+  }
+
+  // O(k h) strong
+  void lower_bound_many(std::span<const T> keys, std::span<const_iterator> results) const {
+    lower_bound_many_of(keys, results);
+  }
+
+  // O(k h) strong
+  template <std::ranges::contiguous_range Keys, typename C = Compare>
+  requires is_transparent<C>
+  void lower_bound_many(const Keys& keys, std::span<const_iterator> results) const {
+    lower_bound_many_of(std::span<const std::ranges::range_value_t<Keys>>(keys), results);
+  }
+
+  // O(k h) strong
+  void contains_many(std::span<const T> keys, std::span<bool> results) const {
+    contains_many_of(keys, results);
+  }
+
+  // O(k h) strong
+  template <std::ranges::contiguous_range Keys, typename C = Compare>
+  requires is_transparent<C>
+  void contains_many(const Keys& keys, std::span<bool> results) const {
+    contains_many_of(std::span<const std::ranges::range_value_t<Keys>>(keys), results);
+  }
+
+  // O(h) strong
+  // Number of elements less than `value`.
+  size_t rank(const T& value) const {
+    return rank_of(value);
+  }
+
+  // O(h) strong
+  template <typename K, typename C = Compare>
+  requires is_transparent<C>
+  size_t rank(const K& key) const {
+    return rank_of(key);
+  }
+
+  // O(h) nothrow
+  // The element with `k` elements before it, or `end()` if `k == size()`.
+  const_iterator nth(size_t k) const noexcept {
+    if constexpr (is_checked) {
+      expects(k <= size());
+    }
+    base_node* t = _root.left;
+    while (t) {
+      size_t left_size = subtree_size(t->left);
+      if (k < left_size) {
+        t = t->left;
+      } else if (k == left_size) {
+        return const_iterator(t, this);
+      } else {
+        k -= left_size + 1;
+        t = t->right;
+      }
+    }
+    return end();
+  }
+
+  // O(h) strong
+  // Number of elements in `[lo, hi)`.
+  size_t count_range(const T& lo, const T& hi) const {
+    return count_range_of(lo, hi);
+  }
+
+  // O(h) strong
+  template <typename K, typename C = Compare>
+  requires is_transparent<C>
+  size_t count_range(const K& lo, const K& hi) const {
+    return count_range_of(lo, hi);
+  }
+
+  // O(1) nothrow
+  // Restarts the generator of node priorities. The same seed followed by the same operations builds the same tree.
+  void seed(std::uint64_t value) noexcept {
+    _priorities.state = value;
+  }
+
+  // O(m log(n / m + 1)) expected, m being the size of the smaller set; basic
+  // Adds the elements of `other`, reusing its nodes; of two equivalent elements the one of this set is kept.
+  // Iterators to the moved elements now refer to this set. If a comparison throws, both sets are left empty.
+  void merge_union(set&& other) {
+    combine<true, true, true>(std::move(other));
+  }
+
+  // O(m) plus the cost of the union with a copy of `other`; basic
+  void merge_union(const set& other) {
+    merge_union(set(other, Allocator(_alloc)));
+  }
+
+  // O(m log(n / m + 1)) expected, m being the size of the smaller set; basic
+  // Keeps the elements that have an equivalent in `other`, which is left empty. If a comparison throws, both sets are
+  // left empty.
+  void intersect(set&& other) {
+    combine<false, false, true>(std::move(other));
+  }
+
+  // O(n log m) if this set is not larger than `other`, otherwise O(m) plus the cost of the intersection with a copy
+  // of `other`; basic
+  void intersect(const set& other) {
+    if (size() <= other.size()) {
+      retain(other, true);
+    } else {
+      intersect(set(other, Allocator(_alloc)));
+    }
+  }
+
+  // O(m log(n / m + 1)) expected, m being the size of the smaller set; basic
+  // Removes the elements that have an equivalent in `other`, which is left empty. If a comparison throws, both sets are
+  // left empty.
+  void difference(set&& other) {
+    combine<true, false, false>(std::move(other));
+  }
+
+  // O(n log m) if this set is not larger than `other`, otherwise O(m) plus the cost of the difference with a copy
+  // of `other`; basic
+  void difference(const set& other) {
+    if (size() <= other.size()) {
+      retain(other, false);
+    } else {
+      difference(set(other, Allocator(_alloc)));
+    }
+  }
+
+  // O(m log(n / m + 1)) expected, m being the size of the smaller set; basic
+  // Keeps the elements of either set that have no equivalent in the other one, reusing the nodes of `other`.
+  // Iterators to the moved elements now refer to this set. If a comparison throws, both sets are left empty.
+  void symmetric_difference(set&& other) {
+    combine<true, true, false>(std::move(other));
+  }
+
+  // O(m) plus the cost of the symmetric difference with a copy of `other`; basic
+  void symmetric_difference(const set& other) {
+    symmetric_difference(set(other, Allocator(_alloc)));
+  }
+
+  // The same operations returning a new set; lvalue arguments are copied first.
+  friend set merge_union(set left, set right) {
+    left.merge_union(std::move(right));
+    return left;
+  }
+
+  friend set intersect(set left, set right) {
+    left.intersect(std::move(right));
+    return left;
+  }
+
+  friend set difference(set left, set right) {
+    left.difference(std::move(right));
+    return left;
+  }
+
+  friend set symmetric_difference(set left, set right) {
+    left.symmetric_difference(std::move(right));
+    return left;
+  }
+
+  // O(h) strong; in the checked mode also O(k h) to hand over the iterators to the moved elements
+  // Moves the elements not less than `key` into a new set. Iterators to them now refer to the returned set.
+  set split_off(const T& key) {
+    return split_off_at(rank_of(key));
+  }
+
+  // O(h) strong; in the checked mode also O(k h) to hand over the iterators to the moved elements
+  template <typename K, typename C = Compare>
+  requires is_transparent<C>
+  set split_off(const K& key) {
+    return split_off_at(rank_of(key));
+  }
+
+  // O(h) strong; in the checked mode also O(k) to hand over the iterators
+  // Appends the elements of `right`, which must all be greater than the elements of this set, and leaves `right`
+  // empty. Iterators to them now refer to this set. If the allocators differ, the elements are copied.
+  void join(set&& right) {
+    if (this == &right || right.empty()) {
+      return;
+    }
+    if constexpr (is_checked) {
+      expects(empty() || _comp(max_value(), right.min_value()));
+    }
+    if constexpr (!node_traits::is_always_equal::value) {
+      if (!(_alloc == right._alloc)) {
+        join(set(right, Allocator(_alloc)));
+        right.clear();
+        return;
+      }
+    }
+    set_root(merge(_root.left, right._root.left));
+    right.set_root(nullptr);
+    _size += std::exchange(right._size, 0);
+    if constexpr (is_checked) {
+      give_iterators(right.take_iterators());
+    }
+  }
+
+  // O(1) strong
+  friend void swap(set& left, set& right) noexcept {
+    if constexpr (node_traits::propagate_on_container_swap::value) {
+      left.swap_storage(right);
+    } else if constexpr (is_checked && !node_traits::is_always_equal::value) {
+      expects(left._alloc == right._alloc);
+    }
+    left.swap_trees(right);
+  }
+
+private:
+  // declared before `_root`, whose registry unlinks the iterators to `end()` from this list when it is destroyed
+  [[no_unique_address]] mutable std::conditional_t<is_checked, owned_iterators, no_owned_iterators> _owned;
+  base_node _root;
+  std::size_t _size = 0;
+  [[no_unique_address]] Compare _comp;
+  [[no_unique_address]] node_allocator _alloc;
+  node_pool _pool;
+  priority_generator _priorities;
+  background_reclaimer* _reclaimer = nullptr;
+  // the smallest element, or the sentinel when the set is empty; the largest one is the parent of the sentinel
+  base_node* _leftmost = &_root;
+  // what `end()` and `rend()` return; declared after `_root`, so they leave the registry of the sentinel before it is
+  // destroyed
+  const_iterator _end{&_root, this};
+  const_reverse_iterator _rend{&_root, this};
+
+  // O(h) nothrow, hangs the tree `root` (possibly null) under the sentinel and finds its extremes
+  void set_root(base_node* root) noexcept {
+    _root.left = root;
+    _leftmost = root ? most_left(root) : &_root;
+    _root.parent = root ? most_right(root) : &_root;
+    adopt_root();
+  }
+
+  // O(1) nothrow, makes the tree under the sentinel point back to it, and the extremes of an empty set to the sentinel
+  void adopt_root() noexcept {
+    if (_root.left) {
+      _root.left->parent = &_root;
+    } else {
+      _leftmost = _root.parent = &_root;
+    }
+  }
+
+  // O(h) nothrow, moves the extremes off `n` before it leaves the tree; they reach the sentinel when `n` is the last
+  void forget_extreme(base_node* n) noexcept {
+    if (n == _root.parent) {
+      _root.parent = n == _leftmost ? &_root : prev_node(n);
+    }
+    if (n == _leftmost) {
+      _leftmost = next_node(n);
+    }
+  }
+
+  // O(n) nothrow, or O(k) for the k iterators of this set if a reclaimer takes the detached tree `t`
+  // Iterators to the elements of `t` are invalidated before this returns either way.
+  void dispose(base_node* t, bool recycle) noexcept {
+    if (!t) {
+      return;
+    }
+    if (_reclaimer) {
+      t->parent = nullptr;
+      if constexpr (is_checked) {
+        invalidate_detached_iterators();
+      }
+      try {
+        _reclaimer->submit([t, alloc = _alloc]() mutable noexcept { release_tree(t, alloc); });
+        return;
+      } catch (...) {
+        // the tree is freed right here instead
+      }
+    }
+    deleting(t, recycle);
+  }
+
+  // O(k h) nothrow, k being the number of iterators of this set; O(k) if the set is empty
+  // Invalidates the iterators to elements that no longer hang under the sentinel of this set.
+  void invalidate_detached_iterators() noexcept {
+    checked_iterator* it = _owned.iterators;
+    while (it) {
+      checked_iterator* next = it->next_owned;
+      if (!it->_node->is_sentinel() && (!_root.left || sentinel_of(it->_node) != &_root)) {
+        it->leave_node();
+        it->leave_owner();
+        it->is_valid = false;
+      }
+      it = next;
+    }
+  }
+
+  // O(1) nothrow, leaves the allocators in place; in the checked mode also O(k) to hand the iterators over
+  void swap_trees(set& other) noexcept {
+    using std::swap;
+    swap(_comp, other._comp);
+    std::swap(_root.left, other._root.left);
+    std::swap(_leftmost, other._leftmost);
+    std::swap(_root.parent, other._root.parent);
+    std::swap(_size, other._size);
+    adopt_root();
+    other.adopt_root();
+    if constexpr (is_checked) {
+      checked_iterator* ours = take_iterators();
+      give_iterators(other.take_iterators());
+      other.give_iterators(ours);
+    }
+  }
+
+  // O(k) nothrow
+  // Unlinks the iterators to elements from the list of this set and returns them chained through `next_owned`.
+  checked_iterator* take_iterators() noexcept {
+    checked_iterator* taken = nullptr;
+    checked_iterator* it = _owned.iterators;
+    while (it) {
+      checked_iterator* next = it->next_owned;
+      if (!it->_node->is_sentinel()) {
+        it->leave_owner();
+        it->next_owned = taken;
+        taken = it;
+      }
+      it = next;
+    }
+    return taken;
+  }
+
+  // O(k) nothrow, makes this set the owner of a chain returned by `take_iterators`
+  void give_iterators(checked_iterator* taken) noexcept {
+    while (taken) {
+      checked_iterator* next = taken->next_owned;
+      taken->owner = this;
+      taken->join_owner();
+      taken = next;
+    }
+  }
+
+  // O(k h) nothrow
+  // Like `take_iterators`, but only takes the iterators whose nodes no longer hang under the sentinel of this set.
+  checked_iterator* take_moved_iterators() noexcept {
+    checked_iterator* taken = nullptr;
+    checked_iterator* it = _owned.iterators;
+    while (it) {
+      checked_iterator* next = it->next_owned;
+      if (sentinel_of(it->_node) != &_root) {
+        it->leave_owner();
+        it->next_owned = taken;
+        taken = it;
+      }
+      it = next;
+    }
+    return taken;
+  }
+
+  // O(h) nothrow, the sentinel of the tree holding `n`, or null if that tree is detached
+  static const base_node* sentinel_of(const base_node* n) noexcept {
+    while (n && !n->is_sentinel()) {
+      n = n->parent;
+    }
+    return n;
+  }
+
+  // O(h) strong
+  // Moves the elements from index `k` on into a new set sharing the comparator and the allocator of this one.
+  set split_off_at(size_t k) {
+    set result(_comp, Allocator(_alloc));
+    base_node* left = nullptr;
+    base_node* right = nullptr;
+    split_at(_root.left, k, left, right);
+    set_root(left);
+    result.set_root(right);
+    result._size = _size - k;
+    _size = k;
+    if constexpr (is_checked) {
+      result.give_iterators(take_moved_iterators());
+    }
+    return result;
+  }
+
+  // Runs a set operation on the trees of this set and `other`; the flags tell which elements of the result to keep:
+  // those only in this set, those only in `other`, and those in both (as the node of this set).
+  template <bool KeepOwn, bool KeepOther, bool KeepCommon>
+  void combine(set&& other) {
+    if constexpr (!node_traits::is_always_equal::value) {
+      if (!(_alloc == other._alloc)) {
+        combine<KeepOwn, KeepOther, KeepCommon>(set(other, Allocator(_alloc)));
+        other.clear();
+        return;
+      }
+    }
+    if (this == &other) {
+      if constexpr (!KeepCommon) {
+        clear();
+      }
+      return;
+    }
+    base_node* own = _root.left;
+    base_node* others = other._root.left;
+    set_root(nullptr);
+    other.set_root(nullptr);
+    size_t total = std::exchange(_size, 0) + std::exchange(other._size, 0);
+    size_t removed = 0;
+    set_root(combine_trees<KeepOwn, KeepOther, KeepCommon>(own, others, removed));
+    _size = total - removed;
+    if constexpr (is_checked) {
+      give_iterators(other.take_iterators());
+    }
+  }
+
+  // O(n log m) basic
+  // Walks this set in order and removes the elements whose presence in `other` differs from `present`.
+  void retain(const set& other, bool present) {
+    base_node* n = _leftmost;
+    while (n != &_root) {
+      base_node* next = next_node(n);
+      if ((other.find(other._root.left, static_cast<node*>(n)->value) != nullptr) != present) {
+        remove_node(n);
+      }
+      n = next;
+    }
+  }
+
+  // O(h) nothrow, replaces `n` with the merge of its children and destroys it
+  void remove_node(base_node* n) noexcept {
+    unlink_node(n);
+    destroy_node(n);
+  }
+
+  // O(h) nothrow, replaces `n` with the merge of its children, leaving `n` a detached leaf
+  void unlink_node(base_node* n) noexcept {
+    forget_extreme(n);
+    base_node* kids = merge(n->left, n->right);
+    (n->parent->left == n ? n->parent->left : n->parent->right) = kids;
+    if (kids) {
+      kids->parent = n->parent;
+    }
+    adjust_sizes_up(n->parent, -1);
+    _size--;
+    n->left = n->right = n->parent = nullptr;
+    static_cast<node*>(n)->size = 1;
+  }
+
+  // O(h) nothrow
+  // Unlinks `n`, invalidates the iterators to it as erasing would, and wraps it into a handle.
+  node_type extract_node(base_node* n) noexcept {
+    unlink_node(n);
+    if constexpr (is_checked) {
+      n->invalidate();
+    }
+    return node_type(static_cast<node*>(n), _alloc);
+  }
+
+  // O(1) plus the number of iterators to `n` nothrow
+  // Makes this set the owner of the iterators to `n`, which is moving here from another set.
+  void adopt_iterators(base_node* n) noexcept {
+    for (checked_iterator* it = n->iterators; it; it = it->next_registered) {
+      it->leave_owner();
+      it->owner = this;
+      it->join_owner();
+    }
+  }
+
+  // O(h + k) nothrow
+  // Cuts the elements with indices in `[from, to)` out with two splits and a merge, then destroys them.
+  void erase_positions(size_t from, size_t to) noexcept {
+    if (from >= to) {
+      return;
+    }
+    base_node* rest = nullptr;
+    base_node* middle = nullptr;
+    base_node* right = nullptr;
+    split_at(_root.left, to, rest, right);
+    base_node* left = nullptr;
+    split_at(rest, from, left, middle);
+    set_root(merge(left, right));
+    _size -= to - from;
+    dispose(middle, true);
+  }
+
+  // O(h + k) strong, all comparisons happen before the tree is touched
+  template <typename K>
+  size_t erase_range_of(const K& lo, const K& hi) {
+    size_t from = rank_of(lo);
+    size_t to = rank_of(hi);
+    if (from >= to) {
+      return 0;
+    }
+    erase_positions(from, to);
+    return to - from;
+  }
+
+  // O(m log(n / m + 1)) expected; takes ownership of both trees and destroys whatever it owns if a comparison throws
+  // The root with the higher priority splits the other tree; the halves are combined recursively, and the root and
+  // its equivalent from the other tree, if any, go between them. The recursion depth is bounded by the heights.
+  template <bool KeepOwn, bool KeepOther, bool KeepCommon>
+  base_node* combine_trees(base_node* own, base_node* others, size_t& removed) {
+    if (!own || !others) {
+      if (own && !KeepOwn) {
+        removed += deleting(std::exchange(own, nullptr), true);
+      }
+      if (others && !KeepOther) {
+        removed += deleting(std::exchange(others, nullptr), true);
+      }
+      return own ? own : others;
+    }
+    // the parent links of detached subtrees are stale, and `split` reattaches to the parent if a comparison throws
+    own->parent = nullptr;
+    others->parent = nullptr;
+    const bool own_top = static_cast<node*>(own)->key >= static_cast<node*>(others)->key;
+    node* top = static_cast<node*>(own_top ? own : others);
+    base_node* rest = own_top ? others : own;
+    base_node* top_left = std::exchange(top->left, nullptr);
+    base_node* top_right = std::exchange(top->right, nullptr);
+    top->size = 1;
+    base_node* less = nullptr;
+    base_node* greater = nullptr;
+    node* match = nullptr;
+    base_node* left = nullptr;
+    base_node* right = nullptr;
+    try {
+      try {
+        split(rest, top->value, less, greater);
+      } catch (...) {
+        if (!less && !greater) {
+          less = rest;
+        }
+        throw;
       }
+      match = take_equivalent_min(greater, top->value);
+      if (own_top) {
+        left = combine_trees<KeepOwn, KeepOther, KeepCommon>(std::exchange(top_left, nullptr),
+                                                             std::exchange(less, nullptr), removed);
+        right = combine_trees<KeepOwn, KeepOther, KeepCommon>(std::exchange(top_right, nullptr),
+                                                              std::exchange(greater, nullptr), removed);
+      } else {
+        left = combine_trees<KeepOwn, KeepOther, KeepCommon>(std::exchange(less, nullptr),
+                                                             std::exchange(top_left, nullptr), removed);
+        right = combine_trees<KeepOwn, KeepOther, KeepCommon>(std::exchange(greater, nullptr),
+                                                              std::exchange(top_right, nullptr), removed);
+      }
+    } catch (...) {
+      for (base_node* part : {static_cast<base_node*>(top), static_cast<base_node*>(match), top_left, top_right, less,
+                              greater, left, right}) {
+        removed += deleting(part, true);
+      }
+      throw;
     }
-
-    delete this_node;
-    return pos;
+    node* own_node = own_top ? top : match;
+    node* other_node = own_top ? match : top;
+    node* middle = nullptr;
+    if (own_node && other_node) {
+      middle = KeepCommon ? own_node : nullptr;
+    } else if (own_node) {
+      middle = KeepOwn ? own_node : nullptr;
+    } else {
+      middle = KeepOther ? other_node : nullptr;
+    }
+    for (node* n : {own_node, other_node}) {
+      if (n && n != middle) {
+        destroy_node(n);
+        ++removed;
+      }
+    }
+    // `top` outranks both halves, so the merges are O(1) unless `middle` is its lower-priority equivalent
+    return merge(middle ? merge(left, middle) : left, right);
   }
 
   // O(h) strong
-  size_t erase(const T& value) {
-    if (empty()) {
-      return 0;
+  // Detaches the minimum of `t` if it is equivalent to `value`, which must not be greater than any element of `t`.
+  template <typename K>
+  node* take_equivalent_min(base_node*& t, const K& value) {
+    if (!t) {
+      return nullptr;
     }
-    auto ans = find(value);
-    if (ans == end()) {
-      return 0;
+    base_node** link = &t;
+    while ((*link)->left) {
+      link = &(*link)->left;
     }
-    erase(ans);
-    return 1;
+    node* min = static_cast<node*>(*link);
+    if (_comp(value, min->value)) {
+      return nullptr;
+    }
+    *link = min->right;
+    if (min->right) {
+      min->right->parent = min->parent;
+    }
+    update_sizes_up(min->parent);
+    min->right = nullptr;
+    min->parent = nullptr;
+    min->size = 1;
+    return min;
   }
 
-  // O(h) strong
-  const_iterator lower_bound(const T& value) const {
-    base_node* current = _root.left;
-    const_iterator result = end();
+  // O(n) strong
+  void copy_and_swap(const set& other) {
+    constexpr bool propagate = node_traits::propagate_on_container_copy_assignment::value;
+    set temp(other, propagate ? Allocator(other._alloc) : Allocator(_alloc));
+    swap_trees(temp);
+    if constexpr (propagate) {
+      // `temp` now owns our old nodes and has to free them with the allocator that created them
+      swap_storage(temp);
+    }
+  }
 
-    while (current && current != current->right) {
-      node* current_node = static_cast<node*>(current);
+  // The nodes can take the elements of `other` unless its allocator has to replace ours.
+  bool can_reuse_nodes_for(const set& other) const noexcept {
+    return !node_traits::propagate_on_container_copy_assignment::value || _alloc == other._alloc;
+  }
 
-      if (current_node->value >= value) {
-        result = const_iterator(current, this);
-        current = current->left;
+  // O(n + m) basic, strong if assigning a `T` does not throw
+  // The missing nodes are constructed up front, as copies of any element of `other`, so that the walk afterwards
+  // only assigns values; the nodes are taken in any order, since the shape is copied from `other` anyway.
+  void assign_reusing_nodes(const set& other) {
+    Compare comp = other._comp;
+    base_node* spare = nullptr;
+    size_t spare_count = 0;
+    try {
+      for (; spare_count + _size < other._size; ++spare_count) {
+        base_node* n = construct_node(0, static_cast<const node*>(other._leftmost)->value);
+        n->right = spare;
+        spare = n;
+      }
+    } catch (...) {
+      release_spare(spare);
+      throw;
+    }
+    unroll(std::exchange(_root.left, nullptr), [&spare](base_node* n) {
+      if constexpr (is_checked) {
+        n->invalidate();
+      }
+      n->right = spare;
+      spare = n;
+    });
+    set_root(nullptr);
+    _size = 0;
+    base_node* root = nullptr;
+    try {
+      root = reuse_tree(other._root.left, spare);
+    } catch (...) {
+      release_spare(spare);
+      throw;
+    }
+    release_spare(spare);
+    set_root(root);
+    _size = other._size;
+    using std::swap;
+    swap(_comp, comp);
+  }
+
+  // O(n) basic
+  // Like `clone_tree`, but takes the nodes from the chain `spare`, linked through `right`, which must be long enough.
+  // If an assignment throws, the partial copy is destroyed and `spare` keeps the nodes not used yet.
+  base_node* reuse_tree(const base_node* src, base_node*& spare) {
+    if (!src) {
+      return nullptr;
+    }
+    base_node* root = reuse_node(src, spare);
+    base_node* dst = root;
+    try {
+      while (true) {
+        if (src->left && !dst->left) {
+          dst->left = reuse_node(src->left, spare);
+          dst->left->parent = dst;
+          src = src->left;
+          dst = dst->left;
+        } else if (src->right && !dst->right) {
+          dst->right = reuse_node(src->right, spare);
+          dst->right->parent = dst;
+          src = src->right;
+          dst = dst->right;
+        } else if (dst != root) {
+          src = src->parent;
+          dst = dst->parent;
+        } else {
+          break;
+        }
+      }
+    } catch (...) {
+      deleting(root, true);
+      throw;
+    }
+    return root;
+  }
+
+  // Assigns the value first, so that a throwing assignment leaves the node at the head of `spare`.
+  node* reuse_node(const base_node* src, base_node*& spare) {
+    const node* real = static_cast<const node*>(src);
+    node* n = static_cast<node*>(spare);
+    n->value = real->value;
+    spare = n->right;
+    n->left = n->right = nullptr;
+    n->key = real->key;
+    n->size = real->size;
+    return n;
+  }
+
+  // O(k) nothrow, destroys a chain of detached nodes linked through `right`, pooling their storage as `erase` does
+  void release_spare(base_node* spare) noexcept {
+    while (spare) {
+      destroy_node(std::exchange(spare, spare->right));
+    }
+  }
+
+  // O(1) nothrow, the pool always travels together with the allocator that filled it
+  void swap_storage(set& other) noexcept {
+    using std::swap;
+    swap(_alloc, other._alloc);
+    swap(_pool, other._pool);
+  }
+
+  template <typename V>
+  std::pair<iterator, bool> insert_unique(V&& value) {
+    priority key = _priorities();
+    insert_position pos = locate_insert(value, key);
+    if (pos.existing) {
+      return insert_result(pos.existing, false);
+    }
+    return insert_result(place_node(pos, construct_node(key, std::forward<V>(value))), true);
+  }
+
+  template <typename V>
+  iterator insert_hinted(const_iterator hint, V&& value) {
+    if constexpr (is_checked) {
+      expects(hint.is_valid);
+      expects(hint.owner == this);
+    }
+    base_node* prev = nullptr;
+    base_node* next = nullptr;
+    node* existing = nullptr;
+    if (!locate_near(hint._node, value, prev, next, existing)) {
+      return insert_unique(std::forward<V>(value)).first;
+    }
+    if (existing) {
+      return iterator(existing, this);
+    }
+    return attach_between(prev, next, create_node(std::forward<V>(value)));
+  }
+
+  // O(h) strong, takes ownership of `new_node`
+  std::pair<iterator, bool> emplace_node(node* new_node) {
+    insert_position pos;
+    try {
+      pos = locate_insert(new_node->value, new_node->key);
+    } catch (...) {
+      destroy_node(new_node);
+      throw;
+    }
+    if (pos.existing) {
+      destroy_node(new_node);
+      return insert_result(pos.existing, false);
+    }
+    return insert_result(place_node(pos, new_node), true);
+  }
+
+  // O(1) plus the walk from `hint` to its neighbour; strong
+  // Checks whether `value` belongs right before or right after `hint`. If so, `prev` and `next` are set to the nodes
+  // around its position (the sentinel stands for a missing neighbour), and `existing` to an equivalent element, if any.
+  template <typename K>
+  bool locate_near(base_node* hint, const K& value, base_node*& prev, base_node*& next, node*& existing) const {
+    if (hint->is_sentinel() || _comp(value, static_cast<node*>(hint)->value)) {
+      next = hint;
+      prev = prev_node(hint);
+      if (prev->is_sentinel() || _comp(static_cast<node*>(prev)->value, value)) {
+        return true;
+      }
+      if (_comp(value, static_cast<node*>(prev)->value)) {
+        return false;
+      }
+      existing = static_cast<node*>(prev);
+      return true;
+    }
+    if (!_comp(static_cast<node*>(hint)->value, value)) {
+      existing = static_cast<node*>(hint);
+      return true;
+    }
+    prev = hint;
+    next = next_node(hint);
+    if (next->is_sentinel() || _comp(value, static_cast<node*>(next)->value)) {
+      return true;
+    }
+    if (_comp(static_cast<node*>(next)->value, value)) {
+      return false;
+    }
+    existing = static_cast<node*>(next);
+    return true;
+  }
+
+  // O(h) nothrow: the relinking is O(1) amortized, the subtree sizes of the ancestors are updated
+  // Takes ownership of `new_node`, which has to lie between the adjacent `prev` and `next`.
+  // Hangs the node as a leaf in the free slot between its neighbours and rotates it up until the heap order holds.
+  iterator attach_between(base_node* prev, base_node* next, node* new_node) noexcept {
+    if (!next->left) {
+      next->left = new_node;
+      new_node->parent = next;
+    } else {
+      prev->right = new_node;
+      new_node->parent = prev;
+    }
+    adjust_sizes_up(new_node->parent, 1);
+    while (!new_node->parent->is_sentinel() && static_cast<node*>(new_node->parent)->key < new_node->key) {
+      rotate_up(new_node);
+    }
+    _size++;
+    if (prev == &_root) {
+      _leftmost = new_node;
+    }
+    if (next == &_root) {
+      _root.parent = new_node;
+    }
+    return iterator(new_node, this);
+  }
+
+  // O(1) nothrow, lifts `x` above its parent keeping the order of the elements
+  static void rotate_up(base_node* x) noexcept {
+    base_node* parent = x->parent;
+    base_node* grandparent = parent->parent;
+    if (parent->left == x) {
+      parent->left = x->right;
+      if (x->right) {
+        x->right->parent = parent;
+      }
+      x->right = parent;
+    } else {
+      parent->right = x->left;
+      if (x->left) {
+        x->left->parent = parent;
+      }
+      x->left = parent;
+    }
+    parent->parent = x;
+    x->parent = grandparent;
+    (grandparent->left == parent ? grandparent->left : grandparent->right) = x;
+    static_cast<node*>(x)->size = static_cast<node*>(parent)->size;
+    update_size(parent);
+  }
+
+  // Either the element equivalent to a value, or the link a new node with a given priority takes over: the subtree
+  // hanging there (possibly empty) holds lower priorities and is split around the new node, `below` of its elements
+  // going to the left.
+  struct insert_position {
+    node* existing = nullptr;
+    base_node* parent = nullptr;
+    base_node** link = nullptr;
+    size_t below = 0;
+    bool is_min = true;
+    bool is_max = true;
+  };
+
+  // O(h) strong
+  // One descent with a single comparison per level. The smallest element not less than `value` lies on the search
+  // path; it is the last node where the descent went left, and it is equivalent to `value` unless `value` is less.
+  template <typename K>
+  insert_position locate_insert(const K& value, priority key) {
+    insert_position pos;
+    node* candidate = nullptr;
+    base_node* parent = &_root;
+    base_node** link = &_root.left;
+    while (*link) {
+      node* current = static_cast<node*>(*link);
+      if (!pos.link && current->key < key) {
+        pos.parent = parent;
+        pos.link = link;
+      }
+      parent = current;
+      if (_comp(current->value, value)) {
+        if (pos.link) {
+          pos.below += subtree_size(current->left) + 1;
+        }
+        pos.is_min = false;
+        link = &current->right;
       } else {
-        current = current->right;
+        candidate = current;
+        pos.is_max = false;
+        link = &current->left;
       }
     }
+    if (!pos.link) {
+      pos.parent = parent;
+      pos.link = link;
+    }
+    if (candidate && !_comp(value, candidate->value)) {
+      pos.existing = candidate;
+    }
+    return pos;
+  }
+
+  // O(h) nothrow: the split is O(1) expected, the subtree sizes of the ancestors are updated
+  // Takes ownership of `new_node`, which must not have an equivalent element in the set.
+  // Only the subtree at `pos` is split; in a treap it has an expected constant number of nodes on the search path.
+  // The split follows the count found by the descent, so it compares nothing. Returns `new_node`.
+  node* place_node(const insert_position& pos, node* new_node) noexcept {
+    base_node* left = nullptr;
+    base_node* right = nullptr;
+    split_at(*pos.link, pos.below, left, right);
+    new_node->left = left;
+    new_node->right = right;
+    if (left) {
+      left->parent = new_node;
+    }
+    if (right) {
+      right->parent = new_node;
+    }
+    new_node->parent = pos.parent;
+    update_size(new_node);
+    *pos.link = new_node;
+    adjust_sizes_up(pos.parent, 1);
+    _size++;
+    if (pos.is_min) {
+      _leftmost = new_node;
+    }
+    if (pos.is_max) {
+      _root.parent = new_node;
+    }
+    return new_node;
+  }
+
+  // The result of an insertion, with its iterator registered once, in place.
+  std::pair<iterator, bool> insert_result(base_node* n, bool inserted) const noexcept {
+    std::pair<iterator, bool> result;
+    result.first.point_to(n, this);
+    result.second = inserted;
     return result;
   }
 
-  // O(h) strong
-  const_iterator upper_bound(const T& value) const {
-    base_node* current = _root.left;
-    const_iterator result = end();
+  // O(n) strong, basic if `moving`
+  // Copies the shape, the values and the priorities of the tree rooted at `src`, moving the values out of it if
+  // `moving` is set. The walk uses the parent links of both trees instead of a stack; a child of the copy is still
+  // missing exactly when its subtree is unvisited.
+  template <bool moving = false>
+  base_node* clone_tree(std::conditional_t<moving, base_node*, const base_node*> src) {
+    if (!src) {
+      return nullptr;
+    }
+    base_node* root = clone_node<moving>(src);
+    base_node* dst = root;
+    try {
+      while (true) {
+        if (src->left && !dst->left) {
+          dst->left = clone_node<moving>(src->left);
+          dst->left->parent = dst;
+          src = src->left;
+          dst = dst->left;
+        } else if (src->right && !dst->right) {
+          dst->right = clone_node<moving>(src->right);
+          dst->right->parent = dst;
+          src = src->right;
+          dst = dst->right;
+        } else if (dst != root) {
+          src = src->parent;
+          dst = dst->parent;
+        } else {
+          break;
+        }
+      }
+    } catch (...) {
+      deleting(root, true);
+      throw;
+    }
+    return root;
+  }
 
-    while (current && current != current->right) {
-      node* current_node = static_cast<node*>(current);
+  template <bool moving>
+  node* clone_node(std::conditional_t<moving, base_node*, const base_node*> src) {
+    node* copy;
+    if constexpr (moving) {
+      node* real = static_cast<node*>(src);
+      copy = construct_node(real->key, std::move(real->value));
+    } else {
+      const node* real = static_cast<const node*>(src);
+      copy = construct_node(real->key, real->value);
+    }
+    copy->size = static_cast<const node*>(src)->size;
+    return copy;
+  }
 
-      if (current_node->value > value) {
-        result = const_iterator(current, this);
-        current = current->left;
+  template <typename... Args>
+  node* create_node(Args&&... args) {
+    return construct_node(_priorities(), std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  node* construct_node(priority key, Args&&... args) {
+    node* n = _pool.count != 0 ? _pool.pop() : node_traits::allocate(_alloc, 1);
+    try {
+      node_traits::construct(_alloc, n, std::in_place, key, std::forward<Args>(args)...);
+    } catch (...) {
+      _pool.recycle(n, _alloc);
+      throw;
+    }
+    return n;
+  }
+
+  // Destroys the value and keeps the storage in the pool if `recycle` is set and the pool has room, otherwise frees it.
+  void destroy_node(base_node* n, bool recycle = true) noexcept {
+    node* real = static_cast<node*>(n);
+    node_traits::destroy(_alloc, real);
+    if (recycle) {
+      _pool.recycle(real, _alloc);
+    } else {
+      node_traits::deallocate(_alloc, real, 1);
+    }
+  }
+
+  // O(h), strong
+  // Splits `t` top-down into the elements less than `value` and the rest. The hooks are the links where the next node
+  // of each part is attached, and the links of the node that received a node last still hold the unvisited subtree.
+  // The sizes along both new paths are recomputed bottom-up at the end, following the parent links.
+  // If a comparison throws, that subtree stays where it is, the other hook is closed and the parts are merged back:
+  // the whole tree ends up in `left` and is reattached to the parent of `t`, if any.
+  template <typename K>
+  void split(base_node* t, const K& value, base_node*& left, base_node*& right) const {
+    base_node* const top = t;
+    base_node* const top_parent = t ? t->parent : nullptr;
+    base_node** left_hook = &left;
+    base_node** right_hook = &right;
+    base_node* left_parent = nullptr;
+    base_node* right_parent = nullptr;
+    bool went_left = true;
+    left = right = nullptr;
+    try {
+      while (t) {
+        if (_comp(static_cast<node*>(t)->value, value)) {
+          *left_hook = t;
+          t->parent = left_parent;
+          left_parent = t;
+          left_hook = &t->right;
+          t = t->right;
+          went_left = true;
+        } else {
+          *right_hook = t;
+          t->parent = right_parent;
+          right_parent = t;
+          right_hook = &t->left;
+          t = t->left;
+          went_left = false;
+        }
+      }
+    } catch (...) {
+      if (left == nullptr && right == nullptr) {
+        throw;
+      }
+      *(went_left ? right_hook : left_hook) = nullptr;
+      update_sizes_up(left_parent);
+      update_sizes_up(right_parent);
+      left = merge(left, right);
+      right = nullptr;
+      left->parent = top_parent;
+      if (top_parent) {
+        (top_parent->left == top ? top_parent->left : top_parent->right) = left;
+      }
+      throw;
+    }
+    *left_hook = nullptr;
+    *right_hook = nullptr;
+    update_sizes_up(left_parent);
+    update_sizes_up(right_parent);
+  }
+
+  // O(h) nothrow
+  // Splits `t` into its first `k` elements and the rest, the same way `split` does, but steered by the subtree sizes
+  // instead of comparisons.
+  static void split_at(base_node* t, size_t k, base_node*& left, base_node*& right) noexcept {
+    base_node** left_hook = &left;
+    base_node** right_hook = &right;
+    base_node* left_parent = nullptr;
+    base_node* right_parent = nullptr;
+    left = right = nullptr;
+    while (t) {
+      size_t left_size = subtree_size(t->left);
+      if (left_size < k) {
+        k -= left_size + 1;
+        *left_hook = t;
+        t->parent = left_parent;
+        left_parent = t;
+        left_hook = &t->right;
+        t = t->right;
       } else {
-        current = current->right;
+        *right_hook = t;
+        t->parent = right_parent;
+        right_parent = t;
+        right_hook = &t->left;
+        t = t->left;
       }
     }
-    return result;
+    *left_hook = nullptr;
+    *right_hook = nullptr;
+    update_sizes_up(left_parent);
+    update_sizes_up(right_parent);
   }
 
-  // O(h) strong
-  const_iterator find(const T& value) const {
+  // O(h) nothrow
+  // Merges two treaps whose elements are ordered top-down, splicing the winner of each step into the hook, then
+  // recomputes the sizes along the path of winners.
+  base_node* merge(base_node* left, base_node* right) const noexcept {
+    base_node* root = nullptr;
+    base_node** hook = &root;
+    base_node* parent = nullptr;
+    while (left && right) {
+      if (static_cast<node*>(left)->key > static_cast<node*>(right)->key) {
+        *hook = left;
+        left->parent = parent;
+        parent = left;
+        hook = &left->right;
+        left = left->right;
+      } else {
+        *hook = right;
+        right->parent = parent;
+        parent = right;
+        hook = &right->left;
+        right = right->left;
+      }
+    }
+    *hook = left ? left : right;
+    if (*hook) {
+      (*hook)->parent = parent;
+    }
+    update_sizes_up(parent);
+    return root;
+  }
+
+  template <typename K>
+  node* find(base_node* t, const K& key) const {
+    while (t) {
+      node* current_node = static_cast<node*>(t);
+      if (_comp(key, current_node->value)) {
+        t = current_node->left;
+      } else if (_comp(current_node->value, key)) {
+        t = current_node->right;
+      } else {
+        return current_node;
+      }
+    }
+    return nullptr;
+  }
+
+  // Keys whose descents run interleaved: about as many cache misses as a core keeps in flight, so wider groups
+  // gain nothing.
+  static constexpr size_t lookup_group = 16;
+
+  static void prefetch([[maybe_unused]] const void* address) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address);
+#endif
+  }
+
+  // O(k h) strong
+  // Finds the lower bound of every key, the sentinel standing for none, and passes it to `found(i, bound)`. Each
+  // round moves every unfinished descent of the group one level down and prefetches the node it goes to.
+  template <typename K, typename Found>
+  void lower_bounds(std::span<const K> keys, Found&& found) const {
+    for (size_t first = 0; first < keys.size(); first += lookup_group) {
+      size_t count = std::min(lookup_group, keys.size() - first);
+      base_node* current[lookup_group];
+      base_node* bound[lookup_group];
+      for (size_t i = 0; i < count; ++i) {
+        current[i] = _root.left;
+        bound[i] = const_cast<base_node*>(&_root);
+      }
+      for (bool running = _root.left != nullptr; running;) {
+        running = false;
+        for (size_t i = 0; i < count; ++i) {
+          base_node* n = current[i];
+          if (!n) {
+            continue;
+          }
+          if (!_comp(static_cast<node*>(n)->value, keys[first + i])) {
+            bound[i] = n;
+            n = n->left;
+          } else {
+            n = n->right;
+          }
+          current[i] = n;
+          if (n) {
+            prefetch(n);
+            running = true;
+          }
+        }
+      }
+      for (size_t i = 0; i < count; ++i) {
+        found(first + i, bound[i]);
+      }
+    }
+  }
+
+  template <typename K>
+  void lower_bound_many_of(std::span<const K> keys, std::span<const_iterator> results) const {
+    if constexpr (is_checked) {
+      expects(results.size() >= keys.size());
+    }
+    lower_bounds(keys, [&](size_t i, base_node* bound) { results[i].point_to(bound, this); });
+  }
+
+  template <typename K>
+  void find_many_of(std::span<const K> keys, std::span<const_iterator> results) const {
+    if constexpr (is_checked) {
+      expects(results.size() >= keys.size());
+    }
+    lower_bounds(keys, [&](size_t i, base_node* bound) {
+      results[i].point_to(is_equivalent(bound, keys[i]) ? bound : const_cast<base_node*>(&_root), this);
+    });
+  }
+
+  template <typename K>
+  void contains_many_of(std::span<const K> keys, std::span<bool> results) const {
+    if constexpr (is_checked) {
+      expects(results.size() >= keys.size());
+    }
+    lower_bounds(keys, [&](size_t i, base_node* bound) { results[i] = is_equivalent(bound, keys[i]); });
+  }
+
+  // Whether the lower bound of `key` is an element equivalent to it.
+  template <typename K>
+  bool is_equivalent(const base_node* bound, const K& key) const {
+    return !bound->is_sentinel() && !_comp(key, static_cast<const node*>(bound)->value);
+  }
+
+  template <typename K>
+  const_iterator find_of(const K& key) const {
     if (empty()) {
       return end();
     }
-    node* ans = find(_root.left, value);
+    node* ans = find(_root.left, key);
     if (ans) {
       return const_iterator(ans, this);
     }
     return end();
   }
 
-  // O(1) strong
-  friend void swap(set& left, set& right) noexcept {
-    base_node* left_root = left._root.left;
-    base_node* right_root = right._root.left;
-    std::swap(left._root, right._root);
-    std::swap(left._size, right._size);
-    left_root->parent = &right._root;
-    right_root->parent = &left._root;
+  template <typename K>
+  node_type extract_of(const K& key) {
+    node* n = find(_root.left, key);
+    if (!n) {
+      return node_type();
+    }
+    return extract_node(n);
   }
 
-private:
-  base_node _root;
-  std::size_t _size = 0;
-
-  void split(base_node* t, const T& value, base_node*& left, base_node*& right) const {
-    if (t == nullptr) {
-      left = right = nullptr;
-    } else {
-      node* currentNode = static_cast<node*>(t);
-      if (currentNode->value < value) {
-        left = currentNode;
-        split(currentNode->right, value, left->right, right);
-        if (left->right) {
-          left->right->parent = left;
-        }
-        left->parent = nullptr;
+  template <typename K>
+  size_t rank_of(const K& key) const {
+    size_t rank = 0;
+    base_node* t = _root.left;
+    while (t) {
+      if (_comp(static_cast<node*>(t)->value, key)) {
+        rank += subtree_size(t->left) + 1;
+        t = t->right;
       } else {
-        right = currentNode;
-        split(currentNode->left, value, left, right->left);
-        if (right->left) {
-          right->left->parent = right;
-        }
-        right->parent = nullptr;
+        t = t->left;
       }
     }
+    return rank;
+  }
+
+  template <typename K>
+  size_t count_range_of(const K& lo, const K& hi) const {
+    size_t below_hi = rank_of(hi);
+    size_t below_lo = rank_of(lo);
+    return below_hi > below_lo ? below_hi - below_lo : 0;
   }
 
-  base_node* merge(base_node* left, base_node* right) const {
-    if (left == nullptr || right == nullptr) {
-      return left ? left : right;
+  // The descents keep the candidate as a raw pointer and register only the result.
+  template <typename K>
+  const_iterator lower_bound_of(const K& key) const {
+    base_node* current = _root.left;
+    base_node* result = const_cast<base_node*>(&_root);
+
+    while (current) {
+      if (!_comp(static_cast<node*>(current)->value, key)) {
+        result = current;
+        current = current->left;
+      } else {
+        current = current->right;
+      }
     }
+    return const_iterator(result, this);
+  }
 
-    node* leftNode = static_cast<node*>(left);
-    node* rightNode = static_cast<node*>(right);
+  template <typename K>
+  const_iterator upper_bound_of(const K& key) const {
+    base_node* current = _root.left;
+    base_node* result = const_cast<base_node*>(&_root);
 
-    if (leftNode->key > rightNode->key) {
-      leftNode->right = merge(leftNode->right, right);
-      if (leftNode->right) {
-        leftNode->right->parent = leftNode;
+    while (current) {
+      if (_comp(key, static_cast<node*>(current)->value)) {
+        result = current;
+        current = current->left;
+      } else {
+        current = current->right;
       }
-      return leftNode;
+    }
+    return const_iterator(result, this);
+  }
+
+  // O(n) for sorted input, O(n log n) otherwise; strong. Fills an empty set.
+  template <typename InputIt>
+  void build(InputIt first, InputIt last) {
+    if constexpr (std::forward_iterator<InputIt>) {
+      build_from(first, last, [](const InputIt& it) -> decltype(auto) { return *it; });
     } else {
-      rightNode->left = merge(left, rightNode->left);
-      if (rightNode->left) {
-        rightNode->left->parent = rightNode;
-      }
-      return rightNode;
+      std::vector<T, Allocator> buffer(first, last, Allocator(_alloc));
+      build_from(buffer.begin(), buffer.end(), [](const auto& it) -> decltype(auto) { return std::move(*it); });
     }
   }
 
-  node* find(base_node* t, const T& value) const {
-    if (!t) {
-      return nullptr;
+  // Sorted input is built directly, anything else is built through a sorted vector of positions. Equivalent
+  // elements are ordered by their index, so that the first of them is kept. `std::stable_sort` is avoided: its
+  // buffer comes from the nothrow `operator new`, which would hide an allocation failure instead of reporting it.
+  template <typename It, typename Deref>
+  void build_from(It first, It last, Deref deref) {
+    if (std::is_sorted(first, last, std::ref(_comp))) {
+      build_sorted(first, last, deref);
+      return;
     }
-    node* current_node = static_cast<node*>(t);
-    if (current_node->value == value) {
-      return current_node;
+    using position = std::pair<It, size_t>;
+    std::vector<position, typename node_traits::template rebind_alloc<position>> order(_alloc);
+    size_t index = 0;
+    for (It it = first; it != last; ++it) {
+      order.emplace_back(it, index++);
     }
-    if (value < current_node->value) {
-      return find(current_node->left, value);
-    } else {
-      return find(current_node->right, value);
+    std::sort(order.begin(), order.end(), [this](const position& a, const position& b) {
+      if (_comp(*a.first, *b.first)) {
+        return true;
+      }
+      return !_comp(*b.first, *a.first) && a.second < b.second;
+    });
+    build_sorted(order.begin(), order.end(), [&deref](const auto& it) -> decltype(auto) { return deref(it->first); });
+  }
+
+  // O(n) strong
+  // Builds the Cartesian tree of a sorted sequence in one pass. The right spine of the tree built so far plays the
+  // role of the stack: every new node climbs it past the nodes with lower priorities, which become its left subtree.
+  // A node's size is final once it leaves the spine; the spine itself is sized at the end.
+  // Equivalent neighbours are skipped, so only the first of them is inserted.
+  template <typename It, typename Deref>
+  void build_sorted(It first, It last, Deref deref) {
+    base_node* root = nullptr;
+    base_node* last_node = nullptr;
+    size_t count = 0;
+    try {
+      for (; first != last; ++first) {
+        decltype(auto) value = deref(first);
+        if (last_node && !_comp(static_cast<node*>(last_node)->value, value)) {
+          continue;
+        }
+        node* new_node = create_node(std::forward<decltype(value)>(value));
+        ++count;
+
+        base_node* child = nullptr;
+        base_node* current = last_node;
+        while (current && static_cast<node*>(current)->key < new_node->key) {
+          // the subtree of a node leaving the spine is complete
+          update_size(current);
+          child = current;
+          current = current->parent;
+        }
+        new_node->left = child;
+        if (child) {
+          child->parent = new_node;
+        }
+        new_node->parent = current;
+        if (current) {
+          current->right = new_node;
+        } else {
+          root = new_node;
+        }
+        last_node = new_node;
+      }
+    } catch (...) {
+      deleting(root, true);
+      throw;
+    }
+    update_sizes_up(last_node);
+    set_root(root);
+    _size = count;
+  }
+
+  const T& min_value() const noexcept {
+    return static_cast<const node*>(_leftmost)->value;
+  }
+
+  const T& max_value() const noexcept {
+    return static_cast<const node*>(_root.parent)->value;
+  }
+
+  static base_node* most_right(base_node* n_node) {
+    auto curr = n_node;
+    while (curr->right) {
+      curr = curr->right;
     }
+    return curr;
   }
 
   static base_node* most_left(base_node* n_node) {
@@ -520,12 +2824,49 @@ private:
     return curr;
   }
 
-  void deleting(base_node* t) {
-    if (t == nullptr) {
-      return;
+  // O(n) nothrow, returns the number of destroyed nodes
+  size_t deleting(base_node* t, bool recycle) noexcept {
+    return unroll(t, [this, recycle](base_node* n) { destroy_node(n, recycle); });
+  }
+
+  // O(n) nothrow, frees a detached tree without a set, e.g. on the thread of a reclaimer
+  static void release_tree(base_node* t, node_allocator& alloc) noexcept {
+    unroll(t, [&alloc](base_node* n) {
+      node_traits::destroy(alloc, static_cast<node*>(n));
+      node_traits::deallocate(alloc, static_cast<node*>(n), 1);
+    });
+  }
+
+  // O(n) nothrow, calls `destroy` on every node of `t` and returns their number
+  // Rotates every left child up until the current node has none, then frees it and continues with its right subtree,
+  // so the tree unrolls into a list without recursion or an explicit stack.
+  template <typename Destroy>
+  static size_t unroll(base_node* t, Destroy destroy) noexcept {
+    size_t count = 0;
+    while (t) {
+      if (t->left) {
+        base_node* left = t->left;
+        t->left = left->right;
+        left->right = t;
+        t = left;
+      } else {
+        base_node* next = t->right;
+        destroy(t);
+        ++count;
+        t = next;
+      }
     }
-    deleting(t->left);
-    deleting(t->right);
-    delete t;
+    return count;
   }
-};
\ No newline at end of file
+};
+
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+
+namespace pmr {
+
+template <typename T, typename Checking = checked, typename Compare = std::less<T>>
+using set = ::set<T, Checking, Compare, std::pmr::polymorphic_allocator<T>>;
+
+} // namespace pmr
+#endif
@@ -4,7 +4,18 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <span>
 #include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
 using container = set<element>;
 
@@ -64,9 +75,88 @@ void expect_eq(const Actual& actual, const std::initializer_list<T>& expected) {
   return expect_eq<Actual, std::initializer_list<T>>(actual, expected);
 }
 
+// Checks `nth`, `rank` and iterator distances against a walk over the whole set.
+template <class C>
+void expect_order_statistics(const C& c) {
+  fault_injection_disable dg;
+
+  size_t index = 0;
+  for (auto it = c.begin(); it != c.end(); ++it, ++index) {
+    EXPECT_EQ(it, c.nth(index));
+    EXPECT_EQ(index, c.rank(*it));
+    EXPECT_EQ(static_cast<std::ptrdiff_t>(index), std::ranges::distance(c.begin(), it));
+    EXPECT_EQ(static_cast<std::ptrdiff_t>(c.size() - index), distance(it, c.end()));
+  }
+  EXPECT_EQ(c.size(), index);
+  EXPECT_EQ(c.end(), c.nth(c.size()));
+}
+
+// Stateful allocator that forwards to `operator new`, counts live allocations and propagates on copy assignment
+// and swap.
+template <typename T>
+struct tagged_allocator {
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  explicit tagged_allocator(int tag, size_t* live) : tag(tag), live(live) {}
+
+  template <typename U>
+  tagged_allocator(const tagged_allocator<U>& other) : tag(other.tag), live(other.live) {}
+
+  T* allocate(size_t count) {
+    T* ptr = static_cast<T*>(::operator new(count * sizeof(T)));
+    ++*live;
+    return ptr;
+  }
+
+  void deallocate(T* ptr, size_t) noexcept {
+    --*live;
+    ::operator delete(ptr);
+  }
+
+  friend bool operator==(const tagged_allocator& a, const tagged_allocator& b) {
+    return a.tag == b.tag;
+  }
+
+  int tag;
+  size_t* live;
+};
+
+using tagged_container = set<element, checked, std::less<element>, tagged_allocator<element>>;
+
+// Counts its live instances atomically, so that it can be destroyed on the thread of a reclaimer.
+struct counted {
+  counted(int value) : value(value) {
+    ++live;
+  }
+
+  counted(const counted& other) : value(other.value) {
+    ++live;
+  }
+
+  ~counted() {
+    --live;
+  }
+
+  friend bool operator<(const counted& a, const counted& b) {
+    return a.value < b.value;
+  }
+
+  int value;
+  static inline std::atomic<int> live = 0;
+};
+
+template <typename C>
+class correctness : public ::testing::Test {};
+
+using container_types = ::testing::Types<set<element, checked>, set<element, unchecked>>;
+TYPED_TEST_SUITE(correctness, container_types);
+
 } // namespace
 
-TEST(correctness, single_element) {
+TYPED_TEST(correctness, single_element) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
@@ -74,7 +164,8 @@ TEST(correctness, single_element) {
   EXPECT_EQ(1, c.size());
 }
 
-TEST(correctness, insert) {
+TYPED_TEST(correctness, insert) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
@@ -82,7 +173,8 @@ TEST(correctness, insert) {
   expect_eq(c, {1, 2, 3, 4});
 }
 
-TEST(correctness, copy_ctor) {
+TYPED_TEST(correctness, copy_ctor) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
@@ -91,7 +183,8 @@ TEST(correctness, copy_ctor) {
   expect_eq(c2, {1, 2, 3, 4});
 }
 
-TEST(correctness, copy_ctor_2) {
+TYPED_TEST(correctness, copy_ctor_2) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
@@ -100,7 +193,75 @@ TEST(correctness, copy_ctor_2) {
   expect_eq(c2, {1, 2, 3, 4, 5});
 }
 
-TEST(correctness, copy_ctor_empty) {
+TYPED_TEST(correctness, copy_ctor_independent) {
+  using container = TypeParam;
+  element::no_new_instances_guard g;
+
+  container c;
+  std::vector<int> expected;
+  for (int i = 0; i < 100; ++i) {
+    c.insert((i * 37) % 100);
+    expected.push_back(i);
+  }
+  container c2 = c;
+  expect_eq(c2, expected);
+  c2.erase(c2.find(50));
+  c2.insert(100);
+  expect_eq(c, expected);
+  EXPECT_EQ(100, c2.size());
+  EXPECT_EQ(100, *std::prev(c2.end()));
+}
+
+// Counts the comparisons made through it and its copies; the number of comparisons of a fixed series of lookups
+// depends on the shape of the tree.
+struct counting_less {
+  bool operator()(const element& a, const element& b) const {
+    ++*count;
+    return a < b;
+  }
+
+  size_t* count;
+};
+
+// The checking policy of a set type.
+template <typename C>
+struct checking_of;
+
+template <typename T, typename Checking, typename Compare, typename Allocator>
+struct checking_of<set<T, Checking, Compare, Allocator>> {
+  using type = Checking;
+};
+
+TYPED_TEST(correctness, seed) {
+  using container = set<element, typename checking_of<TypeParam>::type, counting_less>;
+  element::no_new_instances_guard g;
+
+  size_t comparisons = 0;
+  auto lookup_cost = [&](std::uint64_t seed) {
+    container c(counting_less{&comparisons});
+    c.seed(seed);
+    for (int i = 0; i < 100; ++i) {
+      c.insert((i * 37) % 100);
+    }
+    std::vector<int> expected;
+    for (int i = 0; i < 100; ++i) {
+      expected.push_back(i);
+    }
+    expect_eq(c, expected);
+    comparisons = 0;
+    for (int i = 0; i < 100; ++i) {
+      EXPECT_EQ(i, *c.find(i));
+    }
+    return comparisons;
+  };
+  size_t first = lookup_cost(0);
+  EXPECT_EQ(first, lookup_cost(0));
+  EXPECT_NE(first, lookup_cost(1));
+  EXPECT_EQ(lookup_cost(42), lookup_cost(42));
+}
+
+TYPED_TEST(correctness, copy_ctor_empty) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
@@ -108,7 +269,8 @@ TEST(correctness, copy_ctor_empty) {
   EXPECT_TRUE(c2.empty());
 }
 
-TEST(correctness, assignment_operator) {
+TYPED_TEST(correctness, assignment_operator) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
@@ -119,7 +281,8 @@ TEST(correctness, assignment_operator) {
   expect_eq(c2, {1, 2, 3, 4});
 }
 
-TEST(correctness, self_assignment) {
+TYPED_TEST(correctness, self_assignment) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
@@ -128,14 +291,15 @@ TEST(correctness, self_assignment) {
   expect_eq(c, {1, 2, 3, 4});
 }
 
-TEST(correctness, empty) {
+TYPED_TEST(correctness, empty) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
   EXPECT_EQ(c.begin(), c.end());
   EXPECT_TRUE(c.empty());
   EXPECT_EQ(0, c.size());
-  std::pair<container::iterator, bool> p = c.insert(1);
+  std::pair<typename container::iterator, bool> p = c.insert(1);
   EXPECT_NE(c.begin(), c.end());
   EXPECT_FALSE(c.empty());
   EXPECT_EQ(1, c.size());
@@ -145,12 +309,13 @@ TEST(correctness, empty) {
   EXPECT_EQ(0, c.size());
 }
 
-TEST(correctness, iterator_conversions) {
+TYPED_TEST(correctness, iterator_conversions) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
-  container::const_iterator i1 = c.begin();
-  container::iterator i2 = c.end();
+  typename container::const_iterator i1 = c.begin();
+  typename container::iterator i2 = c.end();
   EXPECT_TRUE(i1 == i1);
   EXPECT_TRUE(i1 == i2);
   EXPECT_TRUE(i2 == i1);
@@ -161,14 +326,15 @@ TEST(correctness, iterator_conversions) {
   EXPECT_FALSE(i2 != i2);
 }
 
-TEST(correctness, iterators_postfix) {
+TYPED_TEST(correctness, iterators_postfix) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container s;
   mass_insert(s, {1, 2, 3});
-  container::iterator i = s.begin();
+  typename container::iterator i = s.begin();
   EXPECT_EQ(1, *i);
-  container::iterator j = i++;
+  typename container::iterator j = i++;
   EXPECT_EQ(2, *i);
   EXPECT_EQ(1, *j);
   j = i++;
@@ -182,12 +348,13 @@ TEST(correctness, iterators_postfix) {
   EXPECT_EQ(s.end(), j);
 }
 
-TEST(correctness, iterators_decrement) {
+TYPED_TEST(correctness, iterators_decrement) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container s;
   mass_insert(s, {5, 3, 8, 1, 2, 6, 7, 10});
-  container::iterator i = s.end();
+  typename container::iterator i = s.end();
   EXPECT_EQ(10, *--i);
   EXPECT_EQ(8, *--i);
   EXPECT_EQ(7, *--i);
@@ -199,12 +366,13 @@ TEST(correctness, iterators_decrement) {
   EXPECT_EQ(s.begin(), i);
 }
 
-TEST(correctness, iterators_decrement_2) {
+TYPED_TEST(correctness, iterators_decrement_2) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container s;
   mass_insert(s, {5, 2, 10, 9, 12, 7});
-  container::iterator i = s.end();
+  typename container::iterator i = s.end();
   EXPECT_EQ(12, *--i);
   EXPECT_EQ(10, *--i);
   EXPECT_EQ(9, *--i);
@@ -214,11 +382,12 @@ TEST(correctness, iterators_decrement_2) {
   EXPECT_EQ(s.begin(), i);
 }
 
-TEST(correctness, iterator_default_ctor) {
+TYPED_TEST(correctness, iterator_default_ctor) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
-  container::iterator i;
-  container::const_iterator j;
+  typename container::iterator i;
+  typename container::const_iterator j;
   container s;
   mass_insert(s, {4, 1, 8, 6, 3, 2, 6});
 
@@ -228,17 +397,19 @@ TEST(correctness, iterator_default_ctor) {
   EXPECT_EQ(1, *j);
 }
 
-TEST(correctness, iterator_decrement_end) {
+TYPED_TEST(correctness, iterator_decrement_end) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container s;
-  container::const_iterator i = s.end();
+  typename container::const_iterator i = s.end();
   s.insert(42);
   --i;
   EXPECT_EQ(42, *i);
 }
 
-TEST(correctness, insert_simple) {
+TYPED_TEST(correctness, insert_simple) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
@@ -246,7 +417,8 @@ TEST(correctness, insert_simple) {
   expect_eq(c, {2, 4, 5, 8, 10});
 }
 
-TEST(correctness, insert_duplicates) {
+TYPED_TEST(correctness, insert_duplicates) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
@@ -254,7 +426,8 @@ TEST(correctness, insert_duplicates) {
   expect_eq(c, {2, 4, 8});
 }
 
-TEST(correctness, reinsert) {
+TYPED_TEST(correctness, reinsert) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
@@ -264,7 +437,8 @@ TEST(correctness, reinsert) {
   expect_eq(c, {1, 2, 3, 6, 8, 9});
 }
 
-TEST(correctness, erase_begin) {
+TYPED_TEST(correctness, erase_begin) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
@@ -273,7 +447,8 @@ TEST(correctness, erase_begin) {
   expect_eq(c, {2, 3, 4});
 }
 
-TEST(correctness, erase_middle) {
+TYPED_TEST(correctness, erase_middle) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
@@ -282,7 +457,8 @@ TEST(correctness, erase_middle) {
   expect_eq(c, {1, 2, 4});
 }
 
-TEST(correctness, erase_close_to_end) {
+TYPED_TEST(correctness, erase_close_to_end) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
@@ -291,7 +467,8 @@ TEST(correctness, erase_close_to_end) {
   expect_eq(c, {1, 2, 3, 4, 6});
 }
 
-TEST(correctness, erase_end) {
+TYPED_TEST(correctness, erase_end) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
@@ -300,7 +477,8 @@ TEST(correctness, erase_end) {
   expect_eq(c, {1, 2, 3});
 }
 
-TEST(correctness, erase_root) {
+TYPED_TEST(correctness, erase_root) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
@@ -309,7 +487,8 @@ TEST(correctness, erase_root) {
   expect_eq(c, {1, 2, 3, 8});
 }
 
-TEST(correctness, erase_1) {
+TYPED_TEST(correctness, erase_1) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
@@ -318,7 +497,8 @@ TEST(correctness, erase_1) {
   expect_eq(c, {1, 2, 3, 5, 7, 9, 10, 11, 12});
 }
 
-TEST(correctness, erase_2) {
+TYPED_TEST(correctness, erase_2) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
@@ -327,7 +507,8 @@ TEST(correctness, erase_2) {
   expect_eq(c, {3, 5, 15, 18, 19, 20});
 }
 
-TEST(correctness, erase_3) {
+TYPED_TEST(correctness, erase_3) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
@@ -336,7 +517,8 @@ TEST(correctness, erase_3) {
   expect_eq(c, {5, 10, 13, 14});
 }
 
-TEST(correctness, erase_4) {
+TYPED_TEST(correctness, erase_4) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
@@ -345,7 +527,8 @@ TEST(correctness, erase_4) {
   expect_eq(c, {3, 4, 10, 15});
 }
 
-TEST(correctness, erase_5) {
+TYPED_TEST(correctness, erase_5) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
@@ -354,7 +537,8 @@ TEST(correctness, erase_5) {
   expect_eq(c, {2, 6, 7, 8, 10, 14});
 }
 
-TEST(correctness, erase_6) {
+TYPED_TEST(correctness, erase_6) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
@@ -368,7 +552,8 @@ TEST(correctness, erase_6) {
   EXPECT_TRUE(c.empty());
 }
 
-TEST(correctness, erase_7) {
+TYPED_TEST(correctness, erase_7) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
@@ -378,7 +563,8 @@ TEST(correctness, erase_7) {
   EXPECT_FALSE(c.empty());
 }
 
-TEST(correctness, erase_8) {
+TYPED_TEST(correctness, erase_8) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
@@ -387,28 +573,106 @@ TEST(correctness, erase_8) {
   expect_eq(c, {3});
 }
 
-TEST(correctness, erase_iterator_invalidation) {
+TYPED_TEST(correctness, erase_iterator_invalidation) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
   mass_insert(c, {8, 2, 6, 10, 3, 1, 9, 7});
-  container::iterator i = c.find(8);
-  container::iterator j = std::next(i);
+  typename container::iterator i = c.find(8);
+  typename container::iterator j = std::next(i);
   c.erase(i);
   EXPECT_EQ(9, *j);
 }
 
-TEST(correctness, erase_return_value) {
+TYPED_TEST(correctness, erase_return_value) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
   mass_insert(c, {7, 4, 10, 1, 8, 12});
-  container::iterator i = c.find(7);
+  typename container::iterator i = c.find(7);
   i = c.erase(i);
   EXPECT_EQ(8, *i);
 }
 
-TEST(correctness, clear) {
+TYPED_TEST(correctness, erase_value) {
+  using container = TypeParam;
+  element::no_new_instances_guard g;
+
+  container c;
+  mass_insert(c, {8, 2, 6, 10, 3, 1, 9, 7});
+  typename container::iterator j = c.find(7);
+  EXPECT_EQ(0, c.erase(5));
+  EXPECT_EQ(1, c.erase(6));
+  EXPECT_EQ(0, c.erase(6));
+  EXPECT_EQ(1, c.erase(1));
+  EXPECT_EQ(1, c.erase(10));
+  EXPECT_EQ(7, *j);
+  EXPECT_EQ(3, *std::prev(j));
+  expect_eq(c, {2, 3, 7, 8, 9});
+}
+
+TYPED_TEST(correctness, erase_iterator_range) {
+  using container = TypeParam;
+  element::no_new_instances_guard g;
+
+  container c;
+  for (int i = 0; i < 20; ++i) {
+    c.insert((i * 7) % 20);
+  }
+  typename container::iterator before = c.find(4);
+  typename container::iterator last = c.find(15);
+  typename container::iterator i = c.erase(c.find(5), last);
+  EXPECT_EQ(last, i);
+  EXPECT_EQ(15, *i);
+  EXPECT_EQ(4, *std::prev(i));
+  EXPECT_EQ(i, std::next(before));
+  expect_eq(c, {0, 1, 2, 3, 4, 15, 16, 17, 18, 19});
+  expect_order_statistics(c);
+
+  i = c.erase(i, i);
+  EXPECT_EQ(15, *i);
+  EXPECT_EQ(10, c.size());
+
+  i = c.erase(c.begin(), c.find(2));
+  EXPECT_EQ(c.begin(), i);
+  i = c.erase(c.find(17), c.end());
+  EXPECT_EQ(c.end(), i);
+  expect_eq(c, {2, 3, 4, 15, 16});
+  expect_order_statistics(c);
+
+  c.erase(c.begin(), c.end());
+  EXPECT_TRUE(c.empty());
+  EXPECT_EQ(c.end(), c.begin());
+  c.insert(7);
+  expect_eq(c, {7});
+}
+
+TYPED_TEST(correctness, erase_key_range) {
+  using container = TypeParam;
+  element::no_new_instances_guard g;
+
+  container c;
+  for (int i = 0; i < 50; i += 2) {
+    c.insert(i);
+  }
+  typename container::iterator j = c.find(20);
+  EXPECT_EQ(5, c.erase_range(9, 20));
+  EXPECT_EQ(0, c.erase_range(9, 20));
+  EXPECT_EQ(0, c.erase_range(30, 25));
+  EXPECT_EQ(20, *j);
+  EXPECT_EQ(8, *std::prev(j));
+  EXPECT_EQ(3, c.erase_range(-10, 5));
+  EXPECT_EQ(3, c.erase_range(44, 100));
+  expect_eq(c, {6, 8, 20, 22, 24, 26, 28, 30, 32, 34, 36, 38, 40, 42});
+  expect_order_statistics(c);
+  EXPECT_EQ(14, c.erase_range(0, 100));
+  EXPECT_TRUE(c.empty());
+}
+
+TYPED_TEST(correctness, clear) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
@@ -420,36 +684,349 @@ TEST(correctness, clear) {
   EXPECT_EQ(c.end(), c.begin());
 }
 
-TEST(correctness, iterator_copy) {
+// Checks the cached extremes against the neighbours of `end()`.
+template <class C>
+void expect_extremes(const C& c) {
+  fault_injection_disable dg;
+
+  if (c.empty()) {
+    EXPECT_EQ(c.end(), c.begin());
+    return;
+  }
+  EXPECT_EQ(c.begin(), std::next(c.end(), -static_cast<std::ptrdiff_t>(c.size())));
+  EXPECT_EQ(c.front(), *c.begin());
+  EXPECT_EQ(c.back(), *std::prev(c.end()));
+  EXPECT_EQ(c.back(), *c.rbegin());
+}
+
+TYPED_TEST(correctness, cached_extremes) {
+  using container = TypeParam;
+  element::no_new_instances_guard g;
+
+  container c;
+  expect_extremes(c);
+  mass_insert(c, {5, 3, 8});
+  expect_extremes(c);
+  c.insert(1);
+  c.insert(c.end(), 9);
+  c.insert(c.begin(), 0);
+  c.emplace(10);
+  expect_extremes(c);
+  EXPECT_EQ(0, c.front());
+  EXPECT_EQ(10, c.back());
+  c.erase(c.begin());
+  c.erase(10);
+  expect_extremes(c);
+  EXPECT_EQ(1, c.front());
+  EXPECT_EQ(9, c.back());
+  c.erase(c.begin(), c.find(5));
+  c.erase_range(8, 100);
+  expect_extremes(c);
+  expect_eq(c, {5});
+  c.erase(c.begin());
+  expect_extremes(c);
+
+  mass_insert(c, {4, 2, 6, 7, 1});
+  container right = c.split_off(5);
+  expect_extremes(c);
+  expect_extremes(right);
+  EXPECT_EQ(4, c.back());
+  EXPECT_EQ(6, right.front());
+  c.join(std::move(right));
+  expect_extremes(c);
+  expect_extremes(right);
+  EXPECT_EQ(7, c.back());
+
+  container other;
+  mass_insert(other, {-3, 20});
+  swap(c, other);
+  expect_extremes(c);
+  expect_extremes(other);
+  c.merge_union(std::move(other));
+  expect_extremes(c);
+  EXPECT_EQ(-3, c.front());
+  EXPECT_EQ(20, c.back());
+  container copy = c;
+  expect_extremes(copy);
+  c.merge(copy);
+  c.extract(c.begin());
+  expect_extremes(c);
+  EXPECT_EQ(1, c.front());
+  c.clear();
+  expect_extremes(c);
+}
+
+TYPED_TEST(correctness, front_back_pop) {
+  using container = TypeParam;
+  element::no_new_instances_guard g;
+
+  container c;
+  mass_insert(c, {4, 1, 3, 5, 2});
+  typename container::iterator i = c.find(3);
+  c.pop_front();
+  c.pop_back();
+  expect_eq(c, {2, 3, 4});
+  EXPECT_EQ(2, c.front());
+  EXPECT_EQ(4, c.back());
+  EXPECT_EQ(3, *i);
+  c.pop_back();
+  c.pop_front();
+  EXPECT_EQ(3, c.front());
+  EXPECT_EQ(3, c.back());
+  c.pop_front();
+  EXPECT_TRUE(c.empty());
+  expect_extremes(c);
+}
+
+TYPED_TEST(correctness, reverse_iterators) {
+  using container = TypeParam;
+  using reverse_iterator = typename container::reverse_iterator;
+  static_assert(std::bidirectional_iterator<reverse_iterator>);
+  element::no_new_instances_guard g;
+
+  container c;
+  EXPECT_EQ(c.rend(), c.rbegin());
+  mass_insert(c, {3, 1, 4, 5, 2});
+  reverse_iterator i = c.rbegin();
+  EXPECT_EQ(5, *i);
+  EXPECT_EQ(4, *++i);
+  EXPECT_EQ(4, *i++);
+  EXPECT_EQ(3, *i);
+  EXPECT_EQ(c.find(4), i.base());
+  EXPECT_EQ(3, c.rend() - i);
+  EXPECT_EQ(-3, i - c.rend());
+  EXPECT_EQ(2, distance(c.rbegin(), i));
+  EXPECT_EQ(c.end(), c.rbegin().base());
+  EXPECT_EQ(c.begin(), c.rend().base());
+  EXPECT_EQ(i, reverse_iterator(c.find(4)));
+  EXPECT_EQ(c.rend(), reverse_iterator(c.begin()));
+  EXPECT_EQ(c.rbegin(), reverse_iterator(c.end()));
+
+  reverse_iterator j = c.rend();
+  EXPECT_EQ(1, *--j);
+  EXPECT_EQ(1, *j--);
+  EXPECT_EQ(2, *j);
+  c.erase(5);
+  c.erase(c.begin());
+  EXPECT_EQ(3, *i);
+  EXPECT_EQ(2, *j);
+  EXPECT_EQ(4, *c.rbegin());
+  EXPECT_EQ(3, std::ranges::distance(c.rbegin(), c.rend()));
+}
+
+TYPED_TEST(correctness, move_ctor) {
+  using container = TypeParam;
+  element::no_new_instances_guard g;
+
+  container c;
+  mass_insert(c, {3, 1, 4, 2});
+  typename container::iterator i = c.find(3);
+  container d(std::move(c));
+  expect_eq(d, {1, 2, 3, 4});
+  expect_extremes(d);
+  EXPECT_TRUE(c.empty());
+  expect_extremes(c);
+  EXPECT_EQ(d.find(3), i);
+  d.erase(i);
+  c.insert(7);
+  expect_eq(c, {7});
+  expect_eq(d, {1, 2, 4});
+}
+
+TYPED_TEST(correctness, move_assignment) {
+  using container = TypeParam;
+  element::no_new_instances_guard g;
+
+  container a;
+  container b;
+  mass_insert(a, {1, 2});
+  mass_insert(b, {5, 6, 7});
+  typename container::iterator i = b.find(6);
+  a = std::move(b);
+  expect_eq(a, {5, 6, 7});
+  expect_extremes(a);
+  EXPECT_TRUE(b.empty());
+  EXPECT_EQ(a.find(6), i);
+  EXPECT_EQ(7, *++i);
+  a = std::move(a);
+  expect_eq(a, {5, 6, 7});
+  b = std::move(a);
+  expect_eq(b, {5, 6, 7});
+  EXPECT_EQ(b.find(7), i);
+}
+
+TYPED_TEST(correctness, vector_of_sets) {
+  using container = TypeParam;
+  element::no_new_instances_guard g;
+
+  std::vector<container> sets;
+  std::vector<typename container::iterator> firsts;
+  for (int i = 0; i < 20; ++i) {
+    container c;
+    mass_insert(c, {i, i + 1, i + 2});
+    firsts.push_back(c.begin());
+    sets.push_back(std::move(c));
+  }
+  for (int i = 0; i < 20; ++i) {
+    expect_eq(sets[i], {i, i + 1, i + 2});
+    EXPECT_EQ(sets[i].begin(), firsts[i]);
+  }
+}
+
+TYPED_TEST(correctness, iterator_move) {
+  using container = TypeParam;
+  element::no_new_instances_guard g;
+
+  container c;
+  mass_insert(c, {1, 2, 3});
+  typename container::iterator i = c.find(2);
+  typename container::iterator j = std::move(i);
+  EXPECT_EQ(2, *j);
+  i = c.find(3);
+  j = std::move(i);
+  EXPECT_EQ(3, *j);
+  i = j;
+  EXPECT_EQ(j, i);
+  c.erase(j);
+  EXPECT_EQ(c.end(), c.find(3));
+  i = c.begin();
+  EXPECT_EQ(1, *i);
+}
+
+// Addresses of the elements, in order of address.
+template <class C>
+std::vector<const typename C::value_type*> element_addresses(const C& c) {
+  std::vector<const typename C::value_type*> result;
+  for (const auto& e : c) {
+    result.push_back(&e);
+  }
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+TYPED_TEST(correctness, assign_reuses_nodes) {
+  using container = TypeParam;
+  element::no_new_instances_guard g;
+
+  container c;
+  mass_insert(c, {5, 3, 8, 1});
+  container other;
+  mass_insert(other, {10, 40, 20, 30});
+  typename container::iterator e = c.end();
+  auto addresses = element_addresses(c);
+  c.assign(other);
+  expect_eq(c, {10, 20, 30, 40});
+  expect_extremes(c);
+  expect_order_statistics(c);
+  EXPECT_EQ(addresses, element_addresses(c));
+  EXPECT_EQ(c.end(), e);
+
+  other.insert(25);
+  other.insert(50);
+  c.assign(other);
+  expect_eq(c, {10, 20, 25, 30, 40, 50});
+  expect_order_statistics(c);
+  other.erase_range(20, 45);
+  c.assign(other);
+  expect_eq(c, {10, 50});
+  expect_extremes(c);
+  c.assign(c);
+  expect_eq(c, {10, 50});
+  c.assign(container());
+  EXPECT_TRUE(c.empty());
+  expect_extremes(c);
+  c.assign(other);
+  expect_eq(c, {10, 50});
+  c.insert(30);
+  expect_eq(c, {10, 30, 50});
+  expect_eq(other, {10, 50});
+}
+
+TYPED_TEST(correctness, batched_lookups) {
+  using container = TypeParam;
+  using iterator = typename container::const_iterator;
+  element::no_new_instances_guard g;
+
+  container c;
+  std::vector<element> keys;
+  for (int i = 0; i < 100; ++i) {
+    if (i % 3 != 0) {
+      c.insert(i);
+    }
+    keys.emplace_back((i * 37) % 103 - 1);
+  }
+  for (size_t count : {size_t(0), size_t(1), size_t(15), size_t(16), size_t(17), keys.size()}) {
+    std::span<const element> batch(keys.data(), count);
+    std::vector<iterator> found(count);
+    std::vector<iterator> bounds(count);
+    std::unique_ptr<bool[]> present(new bool[count + 1]);
+    c.find_many(batch, found);
+    c.lower_bound_many(batch, bounds);
+    c.contains_many(batch, std::span<bool>(present.get(), count));
+    for (size_t i = 0; i < count; ++i) {
+      EXPECT_EQ(c.find(batch[i]), found[i]);
+      EXPECT_EQ(c.lower_bound(batch[i]), bounds[i]);
+      EXPECT_EQ(c.contains(batch[i]), present[i]);
+    }
+  }
+
+  container empty;
+  std::vector<iterator> found(3);
+  empty.find_many(std::span<const element>(keys.data(), 3), found);
+  EXPECT_EQ(empty.end(), found[2]);
+}
+
+TYPED_TEST(correctness, iterator_copy) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
-  container::iterator i;
-  [[maybe_unused]] container::iterator i2 = i;
+  typename container::iterator i;
+  [[maybe_unused]] typename container::iterator i2 = i;
 }
 
-TEST(correctness, iterator_assignment_1) {
+TYPED_TEST(correctness, iterator_assignment_1) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
-  container::iterator i;
-  container::iterator i2;
+  typename container::iterator i;
+  typename container::iterator i2;
   i = i2;
 }
 
-TEST(correctness, iterator_assignment_2) {
+TYPED_TEST(correctness, iterator_assignment_2) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
-  container::iterator i = c.end();
-  container::iterator i2;
+  typename container::iterator i = c.end();
+  typename container::iterator i2;
   i = i2;
 }
 
-TEST(correctness, iterator_deref_1) {
+TYPED_TEST(correctness, many_iterators_one_node) {
+  using container = TypeParam;
+  element::no_new_instances_guard g;
+
+  container c;
+  mass_insert(c, {1, 2, 3, 4, 5});
+  std::vector<typename container::const_iterator> its(100, c.find(3));
+  its.erase(its.begin() + 10, its.begin() + 40);
+  its.erase(its.begin());
+  its.pop_back();
+  c.erase(c.find(2));
+  c.erase(c.find(4));
+  for (const auto& it : its) {
+    EXPECT_EQ(3, *it);
+  }
+}
+
+TYPED_TEST(correctness, iterator_deref_1) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
   mass_insert(c, {1, 2, 3, 4, 5, 6});
-  const container::iterator i = c.find(4);
+  const typename container::iterator i = c.find(4);
   EXPECT_EQ(4, *i);
 }
 
@@ -459,28 +1036,31 @@ void magic(element& c) {
 
 void magic(const element&) {}
 
-TEST(correctness, iterator_deref_2) {
+TYPED_TEST(correctness, iterator_deref_2) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
   mass_insert(c, {1, 2, 3, 4, 5, 6});
-  container::iterator i = c.find(4);
+  typename container::iterator i = c.find(4);
   EXPECT_EQ(4, *i);
   magic(*i);
   expect_eq(c, {1, 2, 3, 4, 5, 6});
 }
 
-TEST(correctness, iterator_deref_3) {
+TYPED_TEST(correctness, iterator_deref_3) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
   mass_insert(c, {1, 2, 3, 4, 5, 6});
-  const container::iterator i = c.find(4);
+  const typename container::iterator i = c.find(4);
   magic(*i.operator->());
   expect_eq(c, {1, 2, 3, 4, 5, 6});
 }
 
-TEST(correctness, swap) {
+TYPED_TEST(correctness, swap) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c1, c2;
@@ -491,7 +1071,8 @@ TEST(correctness, swap) {
   expect_eq(c2, {1, 2, 3, 4});
 }
 
-TEST(correctness, swap_self) {
+TYPED_TEST(correctness, swap_self) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c1;
@@ -499,7 +1080,8 @@ TEST(correctness, swap_self) {
   swap(c1, c1);
 }
 
-TEST(correctness, swap_empty) {
+TYPED_TEST(correctness, swap_empty) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c1, c2;
@@ -512,31 +1094,34 @@ TEST(correctness, swap_empty) {
   EXPECT_TRUE(c2.empty());
 }
 
-TEST(correctness, swap_empty_empty) {
+TYPED_TEST(correctness, swap_empty_empty) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c1, c2;
   swap(c1, c2);
 }
 
-TEST(correctness, swap_empty_self) {
+TYPED_TEST(correctness, swap_empty_self) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c1;
   swap(c1, c1);
 }
 
-TEST(correctness, swap_iterator_validity) {
+TYPED_TEST(correctness, swap_iterator_validity) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c1, c2;
   mass_insert(c1, {1, 2, 3, 4, 5, 6, 7, 8, 9, 10});
   c2.insert(11);
 
-  container::const_iterator c1_begin = c1.begin();
+  typename container::const_iterator c1_begin = c1.begin();
   // container::const_iterator c1_end = c1.end();
 
-  container::const_iterator c2_begin = c2.begin();
+  typename container::const_iterator c2_begin = c2.begin();
   // container::const_iterator c2_end = c2.end();
 
   swap(c1, c2);
@@ -551,7 +1136,8 @@ TEST(correctness, swap_iterator_validity) {
   // EXPECT_EQ(c2_end, c2_begin);
 }
 
-TEST(correctness, swap_1) {
+TYPED_TEST(correctness, swap_1) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
@@ -561,15 +1147,16 @@ TEST(correctness, swap_1) {
   expect_eq(c, {1, 2, 3, 4});
 }
 
-TEST(correctness, swap_iterators_1) {
+TYPED_TEST(correctness, swap_iterators_1) {
+  using container = TypeParam;
     container c1;
     mass_insert(c1, {1, 2, 3});
 
     container c2;
     mass_insert(c2, {4, 5, 6});
 
-    container::iterator i = c1.find(2);
-    container::iterator j = c2.find(5);
+    typename container::iterator i = c1.find(2);
+    typename container::iterator j = c2.find(5);
 
     {
       using std::swap;
@@ -582,7 +1169,8 @@ TEST(correctness, swap_iterators_1) {
     expect_eq(c2, {4, 6});
   }
 
-TEST(correctness, find_in_empty) {
+TYPED_TEST(correctness, find_in_empty) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
@@ -592,7 +1180,8 @@ TEST(correctness, find_in_empty) {
   EXPECT_EQ(c.end(), c.find(42));
 }
 
-TEST(correctness, finds) {
+TYPED_TEST(correctness, finds) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
@@ -613,14 +1202,16 @@ TEST(correctness, finds) {
   EXPECT_EQ(c.end(), c.find(11));
 }
 
-TEST(correctness, lower_bound_empty) {
+TYPED_TEST(correctness, lower_bound_empty) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
   EXPECT_EQ(c.end(), c.lower_bound(5));
 }
 
-TEST(correctness, lower_bounds) {
+TYPED_TEST(correctness, lower_bounds) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
@@ -641,7 +1232,8 @@ TEST(correctness, lower_bounds) {
   EXPECT_EQ(std::next(c.begin(), 7), c.lower_bound(11));
 }
 
-TEST(correctness, upper_bounds) {
+TYPED_TEST(correctness, upper_bounds) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
@@ -662,112 +1254,1374 @@ TEST(correctness, upper_bounds) {
   EXPECT_EQ(std::next(c.begin(), 7), c.upper_bound(11));
 }
 
-TEST(correctness, upper_bound_empty) {
+TYPED_TEST(correctness, upper_bound_empty) {
+  using container = TypeParam;
   element::no_new_instances_guard g;
 
   container c;
   EXPECT_EQ(c.end(), c.upper_bound(5));
 }
 
-TEST(fault_injection, non_throwing_default_ctor) {
-  faulty_run([] {
-    try {
-      container();
-    } catch (...) {
-      fault_injection_disable dg;
-      ADD_FAILURE();
-      throw;
-    }
-  });
+TYPED_TEST(correctness, count_contains) {
+  using container = TypeParam;
+  element::no_new_instances_guard g;
+
+  container c;
+  EXPECT_EQ(0, c.count(1));
+  EXPECT_FALSE(c.contains(1));
+  mass_insert(c, {4, 2, 6});
+  EXPECT_EQ(1, c.count(2));
+  EXPECT_EQ(0, c.count(3));
+  EXPECT_TRUE(c.contains(6));
+  EXPECT_FALSE(c.contains(7));
 }
 
-TEST(fault_injection, copy_ctor) {
-  faulty_run([] {
-    container c;
-    mass_insert(c, {3, 2, 4, 1});
-    container c2 = c;
-    fault_injection_disable dg;
-    expect_eq(c, {1, 2, 3, 4});
-  });
+TYPED_TEST(correctness, emplace) {
+  using container = TypeParam;
+  element::no_new_instances_guard g;
+
+  container c;
+  mass_insert(c, {1, 3});
+  auto [it, inserted] = c.emplace(2);
+  EXPECT_TRUE(inserted);
+  EXPECT_EQ(2, *it);
+  auto [dup, dup_inserted] = c.emplace(3);
+  EXPECT_FALSE(dup_inserted);
+  EXPECT_EQ(c.find(3), dup);
+  EXPECT_EQ(4, *c.emplace_hint(c.end(), 4));
+  EXPECT_EQ(4, *c.emplace_hint(c.begin(), 4));
+  expect_eq(c, {1, 2, 3, 4});
 }
 
-TEST(fault_injection, non_throwing_clear) {
-  faulty_run([] {
-    container c;
-    mass_insert(c, {3, 2, 4, 1});
-    try {
-      c.clear();
-    } catch (...) {
-      fault_injection_disable dg;
-      ADD_FAILURE();
-      throw;
-    }
-  });
+TYPED_TEST(correctness, insert_rvalue) {
+  using container = TypeParam;
+  element::no_new_instances_guard g;
+
+  container c;
+  element e = 5;
+  c.insert(std::move(e));
+  c.insert(element(3));
+  c.insert(element(5));
+  expect_eq(c, {3, 5});
 }
 
-TEST(fault_injection, assignment_operator) {
-  faulty_run([] {
-    container c;
-    mass_insert(c, {3, 2, 4, 1});
-    container c2;
-    mass_insert(c2, {8, 7, 2, 14});
+TYPED_TEST(correctness, insert_hint_ascending) {
+  using container = TypeParam;
+  element::no_new_instances_guard g;
 
-    try {
-      c = c2;
-    } catch (...) {
-      fault_injection_disable dg;
-      expect_eq(c, {1, 2, 3, 4});
-      throw;
-    }
+  container c;
+  std::vector<int> expected;
+  typename container::iterator hint = c.end();
+  for (int i = 0; i < 100; ++i) {
+    hint = c.insert(hint, i);
+    EXPECT_EQ(i, *hint);
+    expected.push_back(i);
+  }
+  for (int i = 100; i < 200; ++i) {
+    EXPECT_EQ(i, *c.insert(c.end(), i));
+    expected.push_back(i);
+  }
+  expect_eq(c, expected);
+}
 
-    fault_injection_disable dg;
-    expect_eq(c, {2, 7, 8, 14});
-  });
+TYPED_TEST(correctness, insert_hint_descending) {
+  using container = TypeParam;
+  element::no_new_instances_guard g;
+
+  container c;
+  std::vector<int> expected;
+  for (int i = 99; i >= 0; --i) {
+    EXPECT_EQ(i, *c.insert(c.begin(), i));
+    expected.insert(expected.begin(), i);
+  }
+  expect_eq(c, expected);
 }
 
-TEST(fault_injection, insert) {
-  faulty_run([] {
-    container c;
-    mass_insert(c, {3, 2, 4, 1});
-    try {
-      c.insert(5);
-    } catch (...) {
-      fault_injection_disable dg;
-      expect_eq(c, {1, 2, 3, 4});
-      throw;
-    }
-    fault_injection_disable dg;
-    expect_eq(c, {1, 2, 3, 4, 5});
-  });
+TYPED_TEST(correctness, insert_hint_wrong) {
+  using container = TypeParam;
+  element::no_new_instances_guard g;
+
+  container c;
+  mass_insert(c, {10, 20, 30, 40});
+  EXPECT_EQ(35, *c.insert(c.begin(), 35));
+  EXPECT_EQ(5, *c.insert(c.end(), 5));
+  EXPECT_EQ(25, *c.insert(c.find(40), element(25)));
+  EXPECT_EQ(15, *c.emplace_hint(c.find(35), 15));
+  expect_eq(c, {5, 10, 15, 20, 25, 30, 35, 40});
 }
 
-TEST(fault_injection, erase) {
-  faulty_run([] {
-    container c;
-    mass_insert(c, {6, 3, 8, 2, 5, 7, 10});
-    element val = 6;
-    try {
-      c.erase(c.find(val));
-    } catch (...) {
-      fault_injection_disable dg;
-      expect_eq(c, {2, 3, 5, 6, 7, 8, 10});
-      throw;
-    }
-    fault_injection_disable dg;
-    expect_eq(c, {2, 3, 5, 7, 8, 10});
-  });
+TYPED_TEST(correctness, insert_hint_existing) {
+  using container = TypeParam;
+  element::no_new_instances_guard g;
+
+  container c;
+  mass_insert(c, {10, 20, 30});
+  EXPECT_EQ(c.find(20), c.insert(c.find(30), 20));
+  EXPECT_EQ(c.find(20), c.insert(c.find(20), 20));
+  EXPECT_EQ(c.find(20), c.insert(c.find(10), 20));
+  EXPECT_EQ(c.find(10), c.emplace_hint(c.end(), 10));
+  expect_eq(c, {10, 20, 30});
 }
 
-TEST(invalid, empty_deref_begin) {
-  EXPECT_EXIT(
-      {
-        container c;
-        *c.begin();
-      },
-      ::testing::KilledBySignal(SIGABRT), "");
+TYPED_TEST(correctness, merge_union) {
+  using container = TypeParam;
+  element::no_new_instances_guard g;
+
+  container a;
+  container b;
+  mass_insert(a, {1, 3, 5, 7});
+  mass_insert(b, {2, 3, 6, 7, 8});
+  typename container::iterator from_a = a.find(3);
+  typename container::iterator from_b = b.find(6);
+  typename container::iterator b_end = b.end();
+  a.merge_union(std::move(b));
+  expect_eq(a, {1, 2, 3, 5, 6, 7, 8});
+  EXPECT_TRUE(b.empty());
+  EXPECT_EQ(a.find(3), from_a);
+  EXPECT_EQ(a.find(6), from_b);
+  EXPECT_EQ(b.end(), b_end);
+  EXPECT_EQ(a.end(), std::next(from_b, 3));
+}
+
+TYPED_TEST(correctness, intersect) {
+  using container = TypeParam;
+  element::no_new_instances_guard g;
+
+  container a;
+  container b;
+  mass_insert(a, {1, 3, 5, 7});
+  mass_insert(b, {2, 3, 6, 7, 8});
+  typename container::iterator from_a = a.find(7);
+  a.intersect(std::move(b));
+  expect_eq(a, {3, 7});
+  EXPECT_TRUE(b.empty());
+  EXPECT_EQ(a.find(7), from_a);
 }
 
-TEST(invalid, empty_dec_begin) {
+TYPED_TEST(correctness, difference) {
+  using container = TypeParam;
+  element::no_new_instances_guard g;
+
+  container a;
+  container b;
+  mass_insert(a, {1, 3, 5, 7});
+  mass_insert(b, {2, 3, 6, 7, 8});
+  a.difference(b);
+  expect_eq(a, {1, 5});
+  expect_eq(b, {2, 3, 6, 7, 8});
+  b.difference(b);
+  EXPECT_TRUE(b.empty());
+}
+
+TYPED_TEST(correctness, symmetric_difference) {
+  using container = TypeParam;
+  element::no_new_instances_guard g;
+
+  container a;
+  container b;
+  mass_insert(a, {1, 3, 5, 7});
+  mass_insert(b, {2, 3, 6, 7, 8});
+  typename container::iterator from_b = b.find(8);
+  a.symmetric_difference(std::move(b));
+  expect_eq(a, {1, 2, 5, 6, 8});
+  EXPECT_EQ(a.find(8), from_b);
+}
+
+TYPED_TEST(correctness, set_operations_returning_new_set) {
+  using container = TypeParam;
+  element::no_new_instances_guard g;
+
+  container a;
+  container b;
+  mass_insert(a, {1, 3, 5, 7});
+  mass_insert(b, {2, 3, 6, 7, 8});
+  expect_eq(merge_union(a, b), {1, 2, 3, 5, 6, 7, 8});
+  expect_eq(intersect(a, b), {3, 7});
+  expect_eq(difference(a, b), {1, 5});
+  expect_eq(symmetric_difference(a, b), {1, 2, 5, 6, 8});
+  expect_eq(a, {1, 3, 5, 7});
+  expect_eq(b, {2, 3, 6, 7, 8});
+}
+
+TYPED_TEST(correctness, set_operations_random) {
+  using container = TypeParam;
+  element::no_new_instances_guard g;
+
+  for (int round = 0; round < 20; ++round) {
+    std::vector<int> left;
+    std::vector<int> right;
+    for (int i = 0; i < 200; ++i) {
+      if ((i * 7 + round) % 3 == 0) {
+        left.push_back(i);
+      }
+      if (round % 4 == 0 ? i % 50 == round % 50 : (i * 11 + round) % 5 < 2) {
+        right.push_back(i);
+      }
+    }
+    container a(left.begin(), left.end());
+    container b(right.begin(), right.end());
+
+    std::vector<int> expected;
+    std::set_union(left.begin(), left.end(), right.begin(), right.end(), std::back_inserter(expected));
+    expect_eq(merge_union(a, b), expected);
+    expected.clear();
+    std::set_intersection(left.begin(), left.end(), right.begin(), right.end(), std::back_inserter(expected));
+    expect_eq(intersect(a, b), expected);
+    expected.clear();
+    std::set_difference(left.begin(), left.end(), right.begin(), right.end(), std::back_inserter(expected));
+    expect_eq(difference(a, b), expected);
+    expected.clear();
+    std::set_symmetric_difference(left.begin(), left.end(), right.begin(), right.end(), std::back_inserter(expected));
+    expect_eq(symmetric_difference(a, b), expected);
+  }
+}
+
+TYPED_TEST(correctness, swap_keeps_iterators) {
+  using container = TypeParam;
+  element::no_new_instances_guard g;
+
+  container a;
+  container b;
+  mass_insert(a, {1, 2});
+  mass_insert(b, {3});
+  typename container::iterator from_a = a.find(2);
+  typename container::iterator a_end = a.end();
+  swap(a, b);
+  EXPECT_EQ(b.find(2), from_a);
+  EXPECT_EQ(b.end(), std::next(from_a));
+  EXPECT_EQ(a.end(), a_end);
+}
+
+TYPED_TEST(correctness, split_off_and_join) {
+  using container = TypeParam;
+  element::no_new_instances_guard g;
+
+  container a;
+  for (int i = 0; i < 30; ++i) {
+    a.insert((i * 11) % 30);
+  }
+  typename container::iterator low = a.find(4);
+  typename container::iterator high = a.find(20);
+  typename container::iterator a_end = a.end();
+  container b = a.split_off(17);
+  expect_eq(a, {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16});
+  expect_eq(b, {17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29});
+  expect_order_statistics(a);
+  expect_order_statistics(b);
+  EXPECT_EQ(a.find(4), low);
+  EXPECT_EQ(b.find(20), high);
+  EXPECT_EQ(a.end(), a_end);
+  EXPECT_EQ(b.end(), std::next(b.find(29)));
+  b.erase(high);
+  EXPECT_EQ(12, b.size());
+
+  container empty = a.split_off(100);
+  EXPECT_TRUE(empty.empty());
+  container all = empty.split_off(0);
+  EXPECT_TRUE(all.empty());
+
+  a.join(std::move(b));
+  EXPECT_TRUE(b.empty());
+  EXPECT_EQ(29, a.size());
+  EXPECT_EQ(a.find(4), low);
+  EXPECT_EQ(21, *std::next(a.find(19)));
+  expect_order_statistics(a);
+
+  container c = a.split_off(0);
+  EXPECT_TRUE(a.empty());
+  EXPECT_EQ(c.find(4), low);
+  a.join(std::move(c));
+  a.join(std::move(c));
+  EXPECT_EQ(29, a.size());
+  EXPECT_EQ(a.begin(), std::prev(low, 4));
+}
+
+TYPED_TEST(correctness, extract_and_insert_node) {
+  using container = TypeParam;
+  element::no_new_instances_guard g;
+
+  container a;
+  container b;
+  mass_insert(a, {5, 1, 8, 3, 9});
+  mass_insert(b, {2, 3});
+  typename container::iterator next = a.find(9);
+  typename container::node_type nh = a.extract(a.find(8));
+  EXPECT_FALSE(nh.empty());
+  EXPECT_EQ(8, nh.value());
+  EXPECT_EQ(9, *next);
+  expect_eq(a, {1, 3, 5, 9});
+  expect_order_statistics(a);
+
+  typename container::insert_return_type r = b.insert(std::move(nh));
+  EXPECT_TRUE(r.inserted);
+  EXPECT_TRUE(r.node.empty());
+  EXPECT_TRUE(nh.empty());
+  EXPECT_EQ(8, *r.position);
+  EXPECT_EQ(b.find(8), r.position);
+  expect_eq(b, {2, 3, 8});
+  expect_order_statistics(b);
+
+  r = b.insert(a.extract(3));
+  EXPECT_FALSE(r.inserted);
+  EXPECT_EQ(3, r.node.value());
+  EXPECT_EQ(b.find(3), r.position);
+  expect_eq(a, {1, 5, 9});
+
+  r.node.value() = 4;
+  r = b.insert(std::move(r.node));
+  EXPECT_TRUE(r.inserted);
+  expect_eq(b, {2, 3, 4, 8});
+
+  EXPECT_TRUE(a.extract(100).empty());
+  r = b.insert(typename container::node_type());
+  EXPECT_FALSE(r.inserted);
+  EXPECT_EQ(b.end(), r.position);
+}
+
+TYPED_TEST(correctness, merge_moves_nodes) {
+  using container = TypeParam;
+  element::no_new_instances_guard g;
+
+  container a;
+  container b;
+  mass_insert(a, {1, 4, 7, 10});
+  mass_insert(b, {2, 4, 6, 8, 10, 12});
+  typename container::iterator moved = b.find(6);
+  typename container::iterator kept = b.find(4);
+  a.merge(b);
+  expect_eq(a, {1, 2, 4, 6, 7, 8, 10, 12});
+  expect_eq(b, {4, 10});
+  expect_order_statistics(a);
+  expect_order_statistics(b);
+  EXPECT_EQ(a.find(6), moved);
+  EXPECT_EQ(7, *std::next(moved));
+  EXPECT_EQ(b.find(4), kept);
+  a.erase(moved);
+  b.merge(container(a));
+  expect_eq(b, {1, 2, 4, 7, 8, 10, 12});
+}
+
+TYPED_TEST(correctness, order_statistics) {
+  using container = TypeParam;
+  element::no_new_instances_guard g;
+
+  container c;
+  expect_order_statistics(c);
+  for (int i = 0; i < 100; ++i) {
+    c.insert((i * 37) % 100);
+  }
+  expect_order_statistics(c);
+  EXPECT_EQ(50, c.rank(50));
+  EXPECT_EQ(50, *c.nth(50));
+  EXPECT_EQ(10, c.count_range(20, 30));
+  EXPECT_EQ(0, c.count_range(30, 20));
+  EXPECT_EQ(100, c.count_range(-5, 500));
+
+  for (int i = 0; i < 100; i += 3) {
+    c.erase(i);
+  }
+  c.erase(c.find(1));
+  expect_order_statistics(c);
+  EXPECT_EQ(0, c.rank(2));
+  EXPECT_EQ(2, c.rank(5));
+  EXPECT_EQ(4, c.count_range(10, 15));
+
+  auto hint = c.end();
+  for (int i = 100; i < 120; ++i) {
+    hint = c.insert(hint, i);
+  }
+  c.insert(c.find(4), 3);
+  c.emplace_hint(c.begin(), 0);
+  expect_order_statistics(c);
+  EXPECT_EQ(3, c.rank(4));
+}
+
+TYPED_TEST(correctness, order_statistics_bulk) {
+  using container = TypeParam;
+  element::no_new_instances_guard g;
+
+  std::vector<int> sorted;
+  std::vector<int> odd;
+  for (int i = 0; i < 200; ++i) {
+    sorted.push_back(i * 2);
+    odd.push_back(i * 2 + 1);
+  }
+  container a(sorted.begin(), sorted.end());
+  expect_order_statistics(a);
+  container b(odd.rbegin(), odd.rend());
+  expect_order_statistics(b);
+  container copy = a;
+  expect_order_statistics(copy);
+  copy.insert(odd.begin(), odd.begin() + 10);
+  expect_order_statistics(copy);
+  copy.insert({1000, 1001, 1002});
+  expect_order_statistics(copy);
+
+  expect_order_statistics(merge_union(a, b));
+  expect_order_statistics(intersect(copy, b));
+  expect_order_statistics(difference(copy, b));
+  expect_order_statistics(symmetric_difference(copy, b));
+  a.difference(copy);
+  expect_order_statistics(a);
+  EXPECT_EQ(0, copy.rank(0));
+  EXPECT_EQ(copy.size(), copy.rank(5000));
+}
+
+TEST(node_handle, relinks_without_allocation) {
+  size_t live = 0;
+  tagged_container a(tagged_allocator<element>(1, &live));
+  tagged_container b(tagged_allocator<element>(1, &live));
+  mass_insert(a, {1, 2, 3});
+  EXPECT_EQ(3, live);
+  for (int i = 0; i < 10; ++i) {
+    b.insert(a.extract(a.begin()));
+    a.insert(b.extract(b.begin()));
+  }
+  EXPECT_EQ(3, live);
+  tagged_container::node_type nh = a.extract(2);
+  EXPECT_EQ(1, nh.get_allocator().tag);
+  EXPECT_EQ(3, live);
+  nh = tagged_container::node_type();
+  EXPECT_EQ(2, live);
+  a.merge(b);
+  EXPECT_EQ(2, live);
+}
+
+TEST(assignment, reuses_nodes_for_nothrow_values) {
+  set<int> a{1, 2, 3, 4, 5, 6};
+  set<int> b{7, 8, 9, 10, 11, 12};
+  auto addresses = element_addresses(a);
+  a = b;
+  expect_eq(a, {7, 8, 9, 10, 11, 12});
+  EXPECT_EQ(addresses, element_addresses(a));
+  b.insert(0);
+  a = b;
+  expect_eq(a, {0, 7, 8, 9, 10, 11, 12});
+  expect_order_statistics(a);
+}
+
+TEST(concurrency, independent_sets) {
+  constexpr int count = 10000;
+  std::vector<set<int>> sets(4);
+  std::vector<std::thread> threads;
+  for (set<int>& s : sets) {
+    threads.emplace_back([&s] {
+      for (int i = 0; i < count; ++i) {
+        s.insert((i * 7919) % count);
+      }
+    });
+  }
+  for (std::thread& t : threads) {
+    t.join();
+  }
+  for (const set<int>& s : sets) {
+    EXPECT_EQ(count, s.size());
+    EXPECT_TRUE(std::is_sorted(s.begin(), s.end()));
+    EXPECT_EQ(count - 1, *std::prev(s.end()));
+  }
+}
+
+TEST(reclaimer, clear_erase_and_destroy) {
+  background_reclaimer reclaimer;
+  {
+    set<counted> c;
+    c.reclaim_with(&reclaimer);
+    for (int i = 0; i < 1000; ++i) {
+      c.insert(i);
+    }
+    set<counted>::iterator kept = c.find(900);
+    EXPECT_EQ(500, c.erase_range(100, 600));
+    EXPECT_EQ(kept, c.erase(c.find(600), kept));
+    EXPECT_EQ(900, kept->value);
+    EXPECT_EQ(99, std::prev(kept)->value);
+    EXPECT_EQ(kept, c.nth(100));
+    EXPECT_EQ(200, c.size());
+    c.clear();
+    EXPECT_TRUE(c.empty());
+    EXPECT_EQ(c.end(), c.begin());
+    c.insert(5);
+    reclaimer.drain();
+    EXPECT_EQ(1, counted::live);
+  }
+  reclaimer.drain();
+  EXPECT_EQ(0, counted::live);
+}
+
+TEST(reclaimer, keeps_iterators_outside_the_range) {
+  background_reclaimer reclaimer;
+  set<int> c;
+  c.reclaim_with(&reclaimer);
+  for (int i = 0; i < 100; ++i) {
+    c.insert(i);
+  }
+  set<int>::iterator low = c.find(10);
+  set<int>::iterator high = c.find(90);
+  set<int>::iterator end = c.end();
+  c.erase_range(20, 80);
+  EXPECT_EQ(80, *std::next(c.find(19)));
+  EXPECT_EQ(90, *high);
+  EXPECT_EQ(10, *low);
+  c.clear();
+  EXPECT_EQ(c.end(), end);
+  c.reclaim_with(nullptr);
+  c.insert(1);
+  c.clear();
+  EXPECT_TRUE(c.empty());
+}
+
+TEST(move_semantics, insert_moves_value) {
+  set<std::string> c;
+  std::string long_value(100, 'x');
+  c.insert(std::move(long_value));
+  EXPECT_TRUE(long_value.empty());
+
+  std::string duplicate(100, 'x');
+  c.insert(std::move(duplicate));
+  EXPECT_EQ(100, duplicate.size());
+
+  c.emplace(3, 'y');
+  EXPECT_EQ("yyy", *std::prev(c.end()));
+}
+
+TYPED_TEST(correctness, range_ctor_sorted) {
+  using container = TypeParam;
+  element::no_new_instances_guard g;
+
+  std::vector<element> values;
+  std::vector<int> expected;
+  for (int i = 0; i < 200; ++i) {
+    values.emplace_back(i / 2);
+    expected.push_back(i);
+  }
+  expected.resize(100);
+  container c(values.begin(), values.end());
+  expect_eq(c, expected);
+  c.insert(1000);
+  c.erase(c.find(50));
+  EXPECT_EQ(100, c.size());
+}
+
+TYPED_TEST(correctness, range_ctor_unsorted) {
+  using container = TypeParam;
+  element::no_new_instances_guard g;
+
+  std::vector<element> values;
+  for (int i = 0; i < 100; ++i) {
+    values.emplace_back((i * 37) % 50);
+  }
+  container c(values.begin(), values.end());
+  std::vector<int> expected;
+  for (int i = 0; i < 50; ++i) {
+    expected.push_back(i);
+  }
+  expect_eq(c, expected);
+}
+
+TYPED_TEST(correctness, initializer_list_ctor) {
+  using container = TypeParam;
+  element::no_new_instances_guard g;
+
+  container c = {5, 1, 4, 1, 3};
+  expect_eq(c, {1, 3, 4, 5});
+  container empty = {};
+  EXPECT_TRUE(empty.empty());
+}
+
+TYPED_TEST(correctness, insert_range) {
+  using container = TypeParam;
+  element::no_new_instances_guard g;
+
+  container c;
+  c.insert({4, 5, 6});
+  c.insert({7, 8, 8, 9});
+  c.insert({3, 1, 2});
+  c.insert({0, 5, 10, 2});
+  c.insert(std::initializer_list<element>{});
+  expect_eq(c, {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10});
+}
+
+TYPED_TEST(correctness, insert_range_keeps_iterators) {
+  using container = TypeParam;
+  element::no_new_instances_guard g;
+
+  container c = {10, 20};
+  typename container::const_iterator i = c.find(20);
+  c.insert({30, 40});
+  c.insert({1, 2});
+  c.insert({15, 25});
+  EXPECT_EQ(20, *i);
+  EXPECT_EQ(25, *++i);
+}
+
+TEST(range, input_iterator) {
+  std::istringstream in("5 3 9 3 1");
+  set<int> c{std::istream_iterator<int>(in), std::istream_iterator<int>()};
+  expect_eq(c, {1, 3, 5, 9});
+}
+
+TEST(comparator, custom_order) {
+  element::no_new_instances_guard g;
+
+  set<element, checked, std::greater<element>> c;
+  mass_insert(c, {3, 1, 4, 1, 5, 9, 2, 6});
+  expect_eq(c, {9, 6, 5, 4, 3, 2, 1});
+  EXPECT_EQ(5, *c.lower_bound(5));
+  EXPECT_EQ(4, *c.upper_bound(5));
+  EXPECT_EQ(c.end(), c.lower_bound(0));
+  c.erase(4);
+  expect_eq(c, {9, 6, 5, 3, 2, 1});
+}
+
+TEST(comparator, transparent_lookup) {
+  set<std::string, checked, std::less<>> c;
+  mass_insert(c, {std::string("a rather long key that does not fit into SSO"), std::string("b"), std::string("d")});
+
+  std::string_view key = "a rather long key that does not fit into SSO";
+  EXPECT_EQ(c.begin(), c.find(key));
+  EXPECT_EQ(c.end(), c.find(std::string_view("c")));
+  EXPECT_TRUE(c.contains(std::string_view("b")));
+  EXPECT_EQ(0, c.count("c"));
+  EXPECT_EQ("d", *c.lower_bound(std::string_view("c")));
+  EXPECT_EQ("d", *c.upper_bound(std::string_view("b")));
+}
+
+TEST(comparator, transparent_batched_lookups) {
+  set<std::string, checked, std::less<>> c;
+  mass_insert(c, {std::string("b"), std::string("d")});
+
+  std::vector<std::string_view> keys{"a", "b", "c"};
+  std::array<set<std::string, checked, std::less<>>::const_iterator, 3> found;
+  c.find_many(keys, found);
+  EXPECT_EQ(c.end(), found[0]);
+  EXPECT_EQ(c.begin(), found[1]);
+  c.lower_bound_many(keys, found);
+  EXPECT_EQ("b", *found[0]);
+  EXPECT_EQ("d", *found[2]);
+  bool present[3];
+  c.contains_many(keys, present);
+  EXPECT_FALSE(present[0]);
+  EXPECT_TRUE(present[1]);
+
+  std::string_view more[2] = {"d", "e"};
+  c.contains_many(more, present);
+  EXPECT_TRUE(present[0]);
+  EXPECT_FALSE(present[1]);
+  c.find_many(std::span<const std::string_view>(keys).subspan(1), found);
+  EXPECT_EQ(c.begin(), found[0]);
+  EXPECT_EQ(c.end(), found[1]);
+}
+
+namespace {
+
+// Has no equality operator, only an ordering through the comparator.
+struct point {
+  int x;
+  int y;
+};
+
+struct by_x {
+  bool operator()(const point& a, const point& b) const {
+    return a.x < b.x;
+  }
+};
+
+} // namespace
+
+TEST(comparator, equivalence_without_equality) {
+  set<point, checked, by_x> c;
+  c.insert({1, 10});
+  EXPECT_FALSE(c.insert({1, 20}).second);
+  c.insert({0, 30});
+  EXPECT_EQ(10, c.find({1, 0})->y);
+  EXPECT_EQ(30, c.begin()->y);
+  EXPECT_EQ(1, c.erase({1, 42}));
+  EXPECT_EQ(1, c.size());
+}
+
+TEST(allocator, nodes_use_allocator) {
+  element::no_new_instances_guard g;
+
+  size_t live = 0;
+  {
+    tagged_container c(tagged_allocator<element>(1, &live));
+    mass_insert(c, {3, 1, 2, 1});
+    EXPECT_EQ(3, live);
+    c.erase(c.find(2));
+    EXPECT_EQ(2, live);
+    expect_eq(c, {1, 3});
+  }
+  EXPECT_EQ(0, live);
+}
+
+TEST(allocator, pool_is_capped_by_reserve) {
+  element::no_new_instances_guard g;
+
+  size_t live = 0;
+  {
+    tagged_container c(tagged_allocator<element>(1, &live));
+    c.reserve(4);
+    for (int i = 0; i < 10; ++i) {
+      c.insert(i);
+    }
+    EXPECT_EQ(10, live);
+    c.clear();
+    EXPECT_EQ(4, live);
+    EXPECT_EQ(4, c.capacity());
+    mass_insert(c, {1, 2});
+    EXPECT_EQ(4, live);
+    c.shrink_to_fit();
+    EXPECT_EQ(2, live);
+    c.clear();
+    EXPECT_EQ(0, live);
+  }
+  EXPECT_EQ(0, live);
+}
+
+TEST(allocator, reserve) {
+  element::no_new_instances_guard g;
+
+  size_t live = 0;
+  {
+    tagged_container c(tagged_allocator<element>(1, &live));
+    c.reserve(8);
+    EXPECT_EQ(8, live);
+    EXPECT_EQ(8, c.capacity());
+    mass_insert(c, {5, 1, 7, 3, 2, 8, 6, 4});
+    c.erase(c.find(3));
+    c.erase(c.find(7));
+    c.insert(9);
+    c.clear();
+    mass_insert(c, {1, 2, 3, 4, 5, 6, 7, 8});
+    EXPECT_EQ(8, live);
+    c.insert(9);
+    EXPECT_EQ(9, live);
+    EXPECT_EQ(9, c.capacity());
+    c.reserve(4);
+    EXPECT_EQ(9, live);
+  }
+  EXPECT_EQ(0, live);
+}
+
+TEST(allocator, copy_assignment_propagates) {
+  element::no_new_instances_guard g;
+
+  size_t live_1 = 0;
+  size_t live_2 = 0;
+  {
+    tagged_container c1(tagged_allocator<element>(1, &live_1));
+    tagged_container c2(tagged_allocator<element>(2, &live_2));
+    mass_insert(c1, {1, 2, 3});
+    mass_insert(c2, {4, 5});
+    c2 = c1;
+    EXPECT_EQ(1, c2.get_allocator().tag);
+    EXPECT_EQ(6, live_1);
+    EXPECT_EQ(0, live_2);
+    expect_eq(c2, {1, 2, 3});
+  }
+  EXPECT_EQ(0, live_1);
+}
+
+TEST(allocator, swap_propagates) {
+  element::no_new_instances_guard g;
+
+  size_t live_1 = 0;
+  size_t live_2 = 0;
+  {
+    tagged_container c1(tagged_allocator<element>(1, &live_1));
+    tagged_container c2(tagged_allocator<element>(2, &live_2));
+    mass_insert(c1, {1, 2, 3});
+    swap(c1, c2);
+    EXPECT_EQ(2, c1.get_allocator().tag);
+    EXPECT_EQ(1, c2.get_allocator().tag);
+    c1.insert(4);
+    EXPECT_EQ(3, live_1);
+    EXPECT_EQ(1, live_2);
+  }
+  EXPECT_EQ(0, live_1);
+  EXPECT_EQ(0, live_2);
+}
+
+TEST(allocator, move_assignment_unequal_moves_elements) {
+  element::no_new_instances_guard g;
+
+  size_t live_1 = 0;
+  size_t live_2 = 0;
+  {
+    tagged_container c1(tagged_allocator<element>(1, &live_1));
+    tagged_container c2(tagged_allocator<element>(2, &live_2));
+    mass_insert(c1, {1, 2, 3});
+    mass_insert(c2, {4});
+    c2 = std::move(c1);
+    EXPECT_EQ(2, c2.get_allocator().tag);
+    expect_eq(c2, {1, 2, 3});
+    EXPECT_EQ(3, live_2);
+    EXPECT_TRUE(c1.empty());
+    EXPECT_EQ(0, live_1);
+
+    tagged_container c3(std::move(c2));
+    EXPECT_EQ(2, c3.get_allocator().tag);
+    expect_eq(c3, {1, 2, 3});
+    EXPECT_TRUE(c2.empty());
+    EXPECT_EQ(3, live_2);
+  }
+  EXPECT_EQ(0, live_1);
+  EXPECT_EQ(0, live_2);
+}
+
+TEST(allocator, move_only_elements) {
+  using pointer = std::unique_ptr<int>;
+  using pointer_allocator = tagged_allocator<pointer>;
+
+  size_t live_1 = 0;
+  size_t live_2 = 0;
+  {
+    set<pointer, checked, std::less<pointer>, pointer_allocator> c1(pointer_allocator(1, &live_1));
+    set<pointer, checked, std::less<pointer>, pointer_allocator> c2(pointer_allocator(2, &live_2));
+    std::vector<int*> values;
+    for (int i = 0; i < 3; ++i) {
+      values.push_back(c1.insert(std::make_unique<int>(i)).first->get());
+    }
+    std::sort(values.begin(), values.end());
+    c2.insert(std::make_unique<int>(3));
+    c2 = std::move(c1);
+    EXPECT_TRUE(c1.empty());
+    EXPECT_EQ(0, live_1);
+    EXPECT_EQ(3, live_2);
+    ASSERT_EQ(3, c2.size());
+    auto it = c2.begin();
+    for (int* value : values) {
+      EXPECT_EQ(value, (it++)->get());
+    }
+  }
+  EXPECT_EQ(0, live_1);
+  EXPECT_EQ(0, live_2);
+
+  std::vector<set<pointer>> sets(4);
+  for (int i = 0; i < 4; ++i) {
+    sets[i].insert(std::make_unique<int>(i));
+  }
+  sets.erase(sets.begin() + 1);
+  ASSERT_EQ(3, sets.size());
+  EXPECT_EQ(0, **sets[0].begin());
+  EXPECT_EQ(2, **sets[1].begin());
+  EXPECT_EQ(3, **sets[2].begin());
+}
+
+#if __has_include(<memory_resource>)
+TEST(allocator, pmr_monotonic_buffer) {
+  element::no_new_instances_guard g;
+
+  std::array<std::byte, 4096> buffer;
+  std::pmr::monotonic_buffer_resource resource(buffer.data(), buffer.size(), std::pmr::null_memory_resource());
+  pmr::set<element> c(&resource);
+  mass_insert(c, {5, 3, 8, 1});
+  pmr::set<element> c2 = c;
+  EXPECT_EQ(std::pmr::get_default_resource(), c2.get_allocator().resource());
+  expect_eq(c, {1, 3, 5, 8});
+  expect_eq(c2, {1, 3, 5, 8});
+}
+
+TEST(allocator, merge_union_unequal_resources) {
+  element::no_new_instances_guard g;
+
+  std::pmr::unsynchronized_pool_resource first;
+  std::pmr::unsynchronized_pool_resource second;
+  pmr::set<element> a(&first);
+  pmr::set<element> b(&second);
+  mass_insert(a, {1, 3});
+  mass_insert(b, {2, 3});
+  a.merge_union(std::move(b));
+  expect_eq(a, {1, 2, 3});
+  EXPECT_TRUE(b.empty());
+  EXPECT_EQ(&first, a.get_allocator().resource());
+}
+
+TEST(allocator, split_off_and_join_unequal_resources) {
+  element::no_new_instances_guard g;
+
+  std::pmr::unsynchronized_pool_resource first;
+  std::pmr::unsynchronized_pool_resource second;
+  pmr::set<element> a(&first);
+  pmr::set<element> b(&second);
+  mass_insert(a, {1, 2, 3});
+  mass_insert(b, {4, 5});
+  pmr::set<element> tail = a.split_off(3);
+  EXPECT_EQ(&first, tail.get_allocator().resource());
+  a.join(std::move(b));
+  expect_eq(a, {1, 2, 4, 5});
+  EXPECT_TRUE(b.empty());
+  EXPECT_EQ(&first, a.get_allocator().resource());
+}
+#endif
+
+TEST(fault_injection, non_throwing_default_ctor) {
+  faulty_run([] {
+    try {
+      container();
+    } catch (...) {
+      fault_injection_disable dg;
+      ADD_FAILURE();
+      throw;
+    }
+  });
+}
+
+TEST(fault_injection, copy_ctor) {
+  faulty_run([] {
+    container c;
+    mass_insert(c, {3, 2, 4, 1});
+    container c2 = c;
+    fault_injection_disable dg;
+    expect_eq(c, {1, 2, 3, 4});
+  });
+}
+
+TEST(fault_injection, copy_ctor_deep) {
+  faulty_run([] {
+    container c;
+    mass_insert(c, {5, 8, 2, 9, 1, 7, 3, 6, 4, 10});
+    container c2 = c;
+    fault_injection_disable dg;
+    expect_eq(c2, {1, 2, 3, 4, 5, 6, 7, 8, 9, 10});
+  });
+}
+
+TEST(fault_injection, non_throwing_clear) {
+  faulty_run([] {
+    container c;
+    mass_insert(c, {3, 2, 4, 1});
+    try {
+      c.clear();
+    } catch (...) {
+      fault_injection_disable dg;
+      ADD_FAILURE();
+      throw;
+    }
+  });
+}
+
+TEST(fault_injection, assignment_operator) {
+  faulty_run([] {
+    container c;
+    mass_insert(c, {3, 2, 4, 1});
+    container c2;
+    mass_insert(c2, {8, 7, 2, 14});
+
+    try {
+      c = c2;
+    } catch (...) {
+      fault_injection_disable dg;
+      expect_eq(c, {1, 2, 3, 4});
+      throw;
+    }
+
+    fault_injection_disable dg;
+    expect_eq(c, {2, 7, 8, 14});
+  });
+}
+
+TEST(fault_injection, assign) {
+  faulty_run([] {
+    container c;
+    mass_insert(c, {3, 2, 4, 1});
+    container c2;
+    mass_insert(c2, {8, 7, 2, 14, 9, 6});
+
+    try {
+      c.assign(c2);
+    } catch (...) {
+      fault_injection_disable dg;
+      if (!c.empty()) {
+        expect_eq(c, {1, 2, 3, 4});
+      }
+      expect_extremes(c);
+      throw;
+    }
+
+    fault_injection_disable dg;
+    expect_eq(c, {2, 6, 7, 8, 9, 14});
+  });
+}
+
+TEST(fault_injection, insert) {
+  faulty_run([] {
+    container c;
+    mass_insert(c, {3, 2, 4, 1});
+    try {
+      c.insert(5);
+    } catch (...) {
+      fault_injection_disable dg;
+      expect_eq(c, {1, 2, 3, 4});
+      throw;
+    }
+    fault_injection_disable dg;
+    expect_eq(c, {1, 2, 3, 4, 5});
+  });
+}
+
+TEST(fault_injection, insert_deep) {
+  faulty_run([] {
+    container c;
+    std::vector<int> expected;
+    {
+      fault_injection_disable dg;
+      for (int i = 0; i < 64; ++i) {
+        c.insert(i * 2);
+        expected.push_back(i * 2);
+      }
+    }
+    container::const_iterator it = c.find(62);
+    try {
+      c.insert(63);
+    } catch (...) {
+      fault_injection_disable dg;
+      expect_eq(c, expected);
+      EXPECT_EQ(64, *std::next(it));
+      throw;
+    }
+    fault_injection_disable dg;
+    expected.insert(expected.begin() + 32, 63);
+    expect_eq(c, expected);
+    EXPECT_EQ(63, *std::next(it));
+  });
+}
+
+TEST(fault_injection, erase) {
+  faulty_run([] {
+    container c;
+    mass_insert(c, {6, 3, 8, 2, 5, 7, 10});
+    element val = 6;
+    try {
+      c.erase(c.find(val));
+    } catch (...) {
+      fault_injection_disable dg;
+      expect_eq(c, {2, 3, 5, 6, 7, 8, 10});
+      throw;
+    }
+    fault_injection_disable dg;
+    expect_eq(c, {2, 3, 5, 7, 8, 10});
+  });
+}
+
+TEST(fault_injection, erase_value) {
+  faulty_run([] {
+    container c;
+    mass_insert(c, {6, 3, 8, 2, 5, 7, 10});
+    try {
+      EXPECT_EQ(1, c.erase(6));
+    } catch (...) {
+      fault_injection_disable dg;
+      expect_eq(c, {2, 3, 5, 6, 7, 8, 10});
+      throw;
+    }
+    fault_injection_disable dg;
+    expect_eq(c, {2, 3, 5, 7, 8, 10});
+  });
+}
+
+TEST(fault_injection, erase_range) {
+  faulty_run([] {
+    container c;
+    mass_insert(c, {6, 3, 8, 2, 5, 7, 10});
+    try {
+      EXPECT_EQ(3, c.erase_range(4, 8));
+    } catch (...) {
+      fault_injection_disable dg;
+      expect_eq(c, {2, 3, 5, 6, 7, 8, 10});
+      throw;
+    }
+    fault_injection_disable dg;
+    expect_eq(c, {2, 3, 8, 10});
+    expect_order_statistics(c);
+  });
+}
+
+TEST(fault_injection, split_off) {
+  faulty_run([] {
+    container c;
+    mass_insert(c, {6, 3, 8, 2, 5, 7, 10});
+    container::const_iterator i = c.find(7);
+    try {
+      container tail = c.split_off(6);
+      fault_injection_disable dg;
+      expect_eq(c, {2, 3, 5});
+      expect_eq(tail, {6, 7, 8, 10});
+      EXPECT_EQ(tail.find(7), i);
+    } catch (...) {
+      fault_injection_disable dg;
+      expect_eq(c, {2, 3, 5, 6, 7, 8, 10});
+      EXPECT_EQ(c.find(7), i);
+      throw;
+    }
+  });
+}
+
+TEST(fault_injection, insert_node) {
+  faulty_run([] {
+    container a;
+    container b;
+    mass_insert(a, {6, 3, 8, 2});
+    mass_insert(b, {5, 7, 10});
+    container::node_type nh = a.extract(3);
+    try {
+      container::insert_return_type r = b.insert(std::move(nh));
+      fault_injection_disable dg;
+      EXPECT_TRUE(r.inserted);
+      expect_eq(b, {3, 5, 7, 10});
+    } catch (...) {
+      fault_injection_disable dg;
+      EXPECT_EQ(3, nh.value());
+      expect_eq(b, {5, 7, 10});
+      throw;
+    }
+  });
+}
+
+TEST(fault_injection, merge) {
+  faulty_run([] {
+    container a;
+    container b;
+    mass_insert(a, {6, 3, 8, 2});
+    mass_insert(b, {5, 3, 10});
+    try {
+      a.merge(b);
+    } catch (...) {
+      fault_injection_disable dg;
+      EXPECT_EQ(7, a.size() + b.size());
+      expect_order_statistics(a);
+      expect_order_statistics(b);
+      throw;
+    }
+    fault_injection_disable dg;
+    expect_eq(a, {2, 3, 5, 6, 8, 10});
+    expect_eq(b, {3});
+  });
+}
+
+TEST(fault_injection, merge_union) {
+  faulty_run([] {
+    container a;
+    container b;
+    mass_insert(a, {1, 3, 5, 7, 9});
+    mass_insert(b, {2, 3, 6, 7, 10});
+    try {
+      a.merge_union(std::move(b));
+    } catch (...) {
+      fault_injection_disable dg;
+      EXPECT_TRUE(a.empty());
+      EXPECT_TRUE(b.empty());
+      throw;
+    }
+    fault_injection_disable dg;
+    expect_eq(a, {1, 2, 3, 5, 6, 7, 9, 10});
+  });
+}
+
+TEST(fault_injection, intersect) {
+  faulty_run([] {
+    container a;
+    container b;
+    mass_insert(a, {1, 3, 5, 7, 9});
+    mass_insert(b, {2, 3, 6, 7, 10});
+    try {
+      a.intersect(std::move(b));
+    } catch (...) {
+      fault_injection_disable dg;
+      EXPECT_TRUE(a.empty());
+      EXPECT_TRUE(b.empty());
+      throw;
+    }
+    fault_injection_disable dg;
+    expect_eq(a, {3, 7});
+  });
+}
+
+TEST(fault_injection, difference_lvalue) {
+  faulty_run([] {
+    container a;
+    container b;
+    mass_insert(a, {1, 3, 5, 7, 9});
+    mass_insert(b, {2, 3, 6, 7, 10});
+    try {
+      a.difference(b);
+    } catch (...) {
+      fault_injection_disable dg;
+      // the elements are removed one by one, so any state between the two is possible
+      EXPECT_TRUE(std::is_sorted(a.begin(), a.end()));
+      for (int x : {1, 5, 9}) {
+        EXPECT_TRUE(a.contains(x));
+      }
+      std::vector<int> original = {1, 3, 5, 7, 9};
+      for (const element& x : a) {
+        EXPECT_TRUE(std::binary_search(original.begin(), original.end(), static_cast<int>(x)));
+      }
+      expect_eq(b, {2, 3, 6, 7, 10});
+      throw;
+    }
+    fault_injection_disable dg;
+    expect_eq(a, {1, 5, 9});
+    expect_eq(b, {2, 3, 6, 7, 10});
+  });
+}
+
+TEST(fault_injection, insert_keeps_sizes) {
+  faulty_run([] {
+    container c;
+    mass_insert(c, {6, 3, 8, 2, 5, 7, 10, 1, 4});
+    try {
+      c.insert(9);
+    } catch (...) {
+      expect_order_statistics(c);
+      throw;
+    }
+    expect_order_statistics(c);
+  });
+}
+
+TEST(fault_injection, insert_with_allocator) {
+  faulty_run([] {
+    size_t live = 0;
+    {
+      tagged_container c(tagged_allocator<element>(1, &live));
+      mass_insert(c, {3, 2, 4, 1});
+      try {
+        c.insert(5);
+      } catch (...) {
+        fault_injection_disable dg;
+        expect_eq(c, {1, 2, 3, 4});
+        throw;
+      }
+      fault_injection_disable dg;
+      expect_eq(c, {1, 2, 3, 4, 5});
+    }
+    fault_injection_disable dg;
+    EXPECT_EQ(0, live);
+  });
+}
+
+TEST(fault_injection, reserve) {
+  faulty_run([] {
+    container c;
+    mass_insert(c, {3, 2, 4, 1});
+    try {
+      c.reserve(10);
+    } catch (...) {
+      fault_injection_disable dg;
+      EXPECT_EQ(4, c.capacity());
+      expect_eq(c, {1, 2, 3, 4});
+      throw;
+    }
+    fault_injection_disable dg;
+    EXPECT_EQ(10, c.capacity());
+    expect_eq(c, {1, 2, 3, 4});
+  });
+}
+
+TEST(fault_injection, emplace) {
+  faulty_run([] {
+    container c;
+    mass_insert(c, {3, 2, 4, 1});
+    try {
+      c.emplace(5);
+    } catch (...) {
+      fault_injection_disable dg;
+      expect_eq(c, {1, 2, 3, 4});
+      throw;
+    }
+    fault_injection_disable dg;
+    expect_eq(c, {1, 2, 3, 4, 5});
+  });
+}
+
+TEST(fault_injection, insert_hint) {
+  faulty_run([] {
+    container c;
+    mass_insert(c, {3, 2, 4, 1});
+    try {
+      c.insert(c.find(4), 5);
+    } catch (...) {
+      fault_injection_disable dg;
+      expect_eq(c, {1, 2, 3, 4});
+      throw;
+    }
+    fault_injection_disable dg;
+    expect_eq(c, {1, 2, 3, 4, 5});
+  });
+}
+
+TEST(fault_injection, emplace_hint_wrong) {
+  faulty_run([] {
+    container c;
+    mass_insert(c, {3, 2, 4, 1});
+    try {
+      c.emplace_hint(c.begin(), 5);
+    } catch (...) {
+      fault_injection_disable dg;
+      expect_eq(c, {1, 2, 3, 4});
+      throw;
+    }
+    fault_injection_disable dg;
+    expect_eq(c, {1, 2, 3, 4, 5});
+  });
+}
+
+TEST(fault_injection, emplace_existing) {
+  faulty_run([] {
+    container c;
+    mass_insert(c, {3, 2, 4, 1});
+    try {
+      c.emplace(3);
+    } catch (...) {
+      fault_injection_disable dg;
+      expect_eq(c, {1, 2, 3, 4});
+      throw;
+    }
+    fault_injection_disable dg;
+    expect_eq(c, {1, 2, 3, 4});
+  });
+}
+
+TEST(fault_injection, range_ctor) {
+  faulty_run([] {
+    std::vector<element> values;
+    {
+      fault_injection_disable dg;
+      for (int v : {3, 1, 4, 1, 5, 9, 2, 6}) {
+        values.emplace_back(v);
+      }
+    }
+    container c(values.begin(), values.end());
+    fault_injection_disable dg;
+    expect_eq(c, {1, 2, 3, 4, 5, 6, 9});
+  });
+}
+
+TEST(fault_injection, insert_range) {
+  faulty_run([] {
+    container c;
+    mass_insert(c, {3, 2, 4, 1});
+    try {
+      c.insert({5, 6, 7});
+    } catch (...) {
+      fault_injection_disable dg;
+      expect_eq(c, {1, 2, 3, 4});
+      throw;
+    }
+    fault_injection_disable dg;
+    expect_eq(c, {1, 2, 3, 4, 5, 6, 7});
+  });
+}
+
+TEST(invalid, empty_deref_begin) {
+  EXPECT_EXIT(
+      {
+        container c;
+        *c.begin();
+      },
+      ::testing::KilledBySignal(SIGABRT), "");
+}
+
+TEST(invalid, empty_dec_begin) {
   EXPECT_EXIT(
       {
         container c;
@@ -777,6 +2631,119 @@ TEST(invalid, empty_dec_begin) {
       ::testing::KilledBySignal(SIGABRT), "");
 }
 
+TEST(invalid, empty_front) {
+  EXPECT_EXIT(
+      {
+        container c;
+        c.front();
+      },
+      ::testing::KilledBySignal(SIGABRT), "");
+}
+
+TEST(invalid, empty_pop_back) {
+  EXPECT_EXIT(
+      {
+        container c;
+        c.pop_back();
+      },
+      ::testing::KilledBySignal(SIGABRT), "");
+}
+
+TEST(invalid, inc_rend) {
+  EXPECT_EXIT(
+      {
+        container c;
+        mass_insert(c, {1, 2});
+        container::reverse_iterator i = c.rend();
+        ++i;
+      },
+      ::testing::KilledBySignal(SIGABRT), "");
+}
+
+TEST(invalid, dec_rbegin) {
+  EXPECT_EXIT(
+      {
+        container c;
+        mass_insert(c, {1, 2});
+        container::reverse_iterator i = c.rbegin();
+        --i;
+      },
+      ::testing::KilledBySignal(SIGABRT), "");
+}
+
+TEST(invalid, deref_rend) {
+  EXPECT_EXIT(
+      {
+        container c;
+        mass_insert(c, {1, 2});
+        *c.rend();
+      },
+      ::testing::KilledBySignal(SIGABRT), "");
+}
+
+TEST(invalid, deref_reverse_after_erase) {
+  EXPECT_EXIT(
+      {
+        container c;
+        mass_insert(c, {1, 2, 3});
+        container::reverse_iterator i = std::next(c.rbegin());
+        c.erase(2);
+        *i;
+      },
+      ::testing::KilledBySignal(SIGABRT), "");
+}
+
+TEST(invalid, dec_reverse_after_erase) {
+  EXPECT_EXIT(
+      {
+        container c;
+        mass_insert(c, {1, 2, 3});
+        container::reverse_iterator i = c.rbegin();
+        c.erase(3);
+        c.shrink_to_fit();
+        --i;
+      },
+      ::testing::KilledBySignal(SIGABRT), "");
+}
+
+TEST(invalid, deref_moved_from_iterator) {
+  EXPECT_EXIT(
+      {
+        container c;
+        mass_insert(c, {1, 2});
+        container::iterator i = c.begin();
+        container::iterator j = std::move(i);
+        *i;
+      },
+      ::testing::KilledBySignal(SIGABRT), "");
+}
+
+TEST(invalid, deref_after_move_assignment) {
+  EXPECT_EXIT(
+      {
+        container c;
+        container c2;
+        mass_insert(c, {1, 2});
+        mass_insert(c2, {3});
+        container::iterator i = c.begin();
+        c = std::move(c2);
+        *i;
+      },
+      ::testing::KilledBySignal(SIGABRT), "");
+}
+
+TEST(invalid, find_many_short_results) {
+  EXPECT_EXIT(
+      {
+        container c;
+        mass_insert(c, {1, 2});
+        std::vector<element> keys(2, element(1));
+        std::vector<container::const_iterator> found(1);
+        c.find_many(keys, found);
+      },
+      ::testing::KilledBySignal(SIGABRT), "");
+}
+
 TEST(invalid, empty_deref_end) {
   EXPECT_EXIT(
       {
@@ -935,6 +2902,114 @@ TEST(invalid, dec_after_erase_dec) {
       ::testing::KilledBySignal(SIGABRT), "");
 }
 
+TEST(invalid, deref_after_erase_many_iterators) {
+  EXPECT_EXIT(
+      {
+        container c;
+        mass_insert(c, {1, 2, 3, 4});
+        std::vector<container::const_iterator> its(10, c.find(3));
+        its.erase(its.begin() + 2);
+        c.erase(c.find(3));
+        *its[5];
+      },
+      ::testing::KilledBySignal(SIGABRT), "");
+}
+
+TEST(invalid, deref_after_erase_range) {
+  EXPECT_EXIT(
+      {
+        container c;
+        mass_insert(c, {1, 2, 3, 4, 5, 6});
+        container::const_iterator i = c.find(4);
+        c.erase(c.find(2), c.find(6));
+        *i;
+      },
+      ::testing::KilledBySignal(SIGABRT), "");
+}
+
+TEST(invalid, erase_reversed_range) {
+  EXPECT_EXIT(
+      {
+        container c;
+        mass_insert(c, {1, 2, 3, 4});
+        c.erase(c.find(3), c.find(2));
+      },
+      ::testing::KilledBySignal(SIGABRT), "");
+}
+
+TEST(invalid, erase_after_split_off) {
+  EXPECT_EXIT(
+      {
+        container c;
+        mass_insert(c, {1, 2, 3, 4});
+        container::const_iterator i = c.find(3);
+        container c2 = c.split_off(2);
+        c.erase(i);
+      },
+      ::testing::KilledBySignal(SIGABRT), "");
+}
+
+TEST(invalid, join_unordered) {
+  EXPECT_EXIT(
+      {
+        container c;
+        container c2;
+        mass_insert(c, {1, 2, 3, 4});
+        mass_insert(c2, {4, 5});
+        c.join(std::move(c2));
+      },
+      ::testing::KilledBySignal(SIGABRT), "");
+}
+
+TEST(invalid, deref_after_extract) {
+  EXPECT_EXIT(
+      {
+        container c;
+        mass_insert(c, {1, 2, 3, 4});
+        container::const_iterator i = c.find(3);
+        container::node_type nh = c.extract(3);
+        *i;
+      },
+      ::testing::KilledBySignal(SIGABRT), "");
+}
+
+TEST(invalid, empty_node_handle_value) {
+  EXPECT_EXIT(
+      {
+        container::node_type nh;
+        std::ignore = nh.value();
+      },
+      ::testing::KilledBySignal(SIGABRT), "");
+}
+
+TEST(invalid, deref_after_background_clear) {
+  EXPECT_EXIT(
+      {
+        background_reclaimer reclaimer;
+        set<int> c;
+        c.reclaim_with(&reclaimer);
+        mass_insert(c, {1, 2, 3, 4});
+        set<int>::const_iterator i = c.find(3);
+        c.clear();
+        *i;
+      },
+      ::testing::KilledBySignal(SIGABRT), "");
+}
+
+TEST(invalid, deref_after_background_erase_range) {
+  EXPECT_EXIT(
+      {
+        background_reclaimer reclaimer;
+        set<int> c;
+        c.reclaim_with(&reclaimer);
+        mass_insert(c, {1, 2, 3, 4});
+        set<int>::const_iterator i = c.find(3);
+        c.erase_range(2, 4);
+        *i;
+      },
+      ::testing::KilledBySignal(SIGABRT), "");
+}
+
 TEST(invalid, deref_after_dtor) {
   EXPECT_EXIT(
       {